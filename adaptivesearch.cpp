@@ -0,0 +1,137 @@
+#include "adaptivesearch.h"
+#include "landmarks.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+void AdaptiveSearch::clear()
+{
+    firstSearch = searchCount + 1;
+}
+
+float AdaptiveSearch::baseHeuristic(int cell) const noexcept
+{
+    int dx = std::abs(grid->xOf(cell) - grid->xOf(goal));
+    int dy = std::abs(grid->yOf(cell) - grid->yOf(goal));
+    float chebyshev = grid->getMinStepCost() * static_cast<float>(std::max(dx, dy));
+    const LandmarkTable *landmarks = grid->getLandmarks();
+    return landmarks ? std::max(chebyshev, landmarks->lowerBound(cell, goal)) : chebyshev;
+}
+
+float AdaptiveSearch::heuristic(int cell) const noexcept
+{
+    float h = baseHeuristic(cell);
+    uint32_t from = learnedIn[cell];
+    if (from < firstSearch) return h;
+    // d(cell, old goal) <= d(cell, goal) + d(goal, old goal), and the shift never exceeds the latter
+    return std::max(h, learned[cell] - (goalShift[searchCount] - goalShift[from]));
+}
+
+std::vector<int> AdaptiveSearch::findPath(const SearchGrid &g, int start, int goalIdx, uint8_t blockerMask,
+                                          float weight)
+{
+    if (start < 0 || start >= g.size() || goalIdx < 0 || goalIdx >= g.size() || start == goalIdx) {
+        return {};
+    }
+
+    // Lower costs would turn learned values into overestimates. Versions are unique across levels
+    // and shared by worker copies, so learning carries over between the copies of one grid
+    grid = &g;
+    if (blockerVersion != g.getBlockerVersion() || mask != blockerMask) {
+        blockerVersion = g.getBlockerVersion();
+        mask = blockerMask;
+        clear();
+    }
+    if (learned.size() != static_cast<size_t>(g.size())) {
+        learned.assign(g.size(), 0.0f);
+        learnedIn.assign(g.size(), 0);
+        searchCount = 0;
+        firstSearch = 1;
+        goalShift.assign(1, 0.0f);
+    }
+    if (searchCount == std::numeric_limits<uint32_t>::max()) {
+        std::fill(learnedIn.begin(), learnedIn.end(), 0);
+        searchCount = 0;
+        firstSearch = 1;
+        goalShift.assign(1, 0.0f);
+    }
+
+    // A blocked goal is entered anyway, which makes cells around it cheaper to reach from than
+    // in the searches that learned with it blocked; only values learned with it open still hold
+    if (g.isBlocked(goalIdx, blockerMask)) {
+        if (exemptGoal != goalIdx) clear();
+        exemptGoal = goalIdx;
+    } else {
+        exemptGoal = -1;
+    }
+
+    // The new goal's estimate under the old goal is how far all older values shift
+    float shift = 0.0f;
+    if (searchCount >= firstSearch && goalIdx != goal) shift = heuristic(goalIdx);
+    goal = goalIdx;
+    ++searchCount;
+    goalShift.push_back(goalShift.back() + shift);
+
+    SearchWorkspace &ws = workspace;
+    // Learned values are the path cost minus g, so both must be exact: the bucket queue may
+    // settle the goal a bucket width late, and that error would pile up search after search
+    ws.setOpenListKind(OpenListKind::BinaryHeap);
+    const float closed = -std::numeric_limits<float>::infinity();
+    ws.begin(g.size());
+    closedCells.clear();
+    ws.reach(start, 0.0f, start);
+    ws.f[start] = weight * heuristic(start);
+    ws.push(ws.f[start], start);
+
+    while (!ws.openEmpty() && !g.isCancelled()) {
+        SearchWorkspace::OpenEntry current = ws.pop();
+        if (current.f > ws.f[current.index]) continue;
+        ++ws.expanded;
+
+        if (current.index == goal) {
+            std::vector<int> path;
+            for (int cell = goal; cell != start; ) {
+                int prev = static_cast<int>(ws.parent[cell]);
+                path.push_back(SearchGrid::directionBetween(g.xOf(prev), g.yOf(prev), g.xOf(cell), g.yOf(cell)));
+                cell = prev;
+            }
+            std::reverse(path.begin(), path.end());
+            learn(closedCells, ws.g[goal], weight);
+            return path;
+        }
+        // Closed for good, as in weighted A*; learned values stay consistent, so nothing needs reopening
+        ws.f[current.index] = closed;
+        closedCells.push_back(current.index);
+
+        int cx = g.xOf(current.index);
+        int cy = g.yOf(current.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!g.inBounds(nx, ny)) continue;
+
+            int next = g.index(nx, ny);
+            float step = next == goal ? g.getStepCost(next) : g.getStepCost(next, blockerMask);
+            if (step == std::numeric_limits<float>::infinity()) continue;
+
+            float newG = ws.g[current.index] + step;
+            if (ws.isReached(next) && (newG >= ws.g[next] || ws.f[next] == closed)) continue;
+
+            ws.reach(next, newG, current.index);
+            ws.f[next] = newG + weight * heuristic(next);
+            ws.push(ws.f[next], next);
+        }
+    }
+
+    return {};
+}
+
+void AdaptiveSearch::learn(const std::vector<int> &cells, float pathCost, float weight)
+{
+    // A weighted path costs at most weight times the optimum, so pathCost / weight never exceeds it
+    float bound = pathCost / weight;
+    for (int cell : cells) {
+        learned[cell] = std::max(heuristic(cell), bound - workspace.g[cell]);
+        learnedIn[cell] = searchCount;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef ADAPTIVESEARCH_H
+#define ADAPTIVESEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Adaptive A*: consecutive searches on one level learn a better heuristic from each other.
+ *
+ * After a search finds a path of cost C, every cell it expanded knows C - g(cell), a lower
+ * bound on its distance to that goal that is usually far tighter than the straight-line or
+ * landmark estimate. The next search starts from those values instead of re-discovering
+ * the same walls. When the goal moves, stored values are corrected lazily as in Generalized
+ * Adaptive A*: a value learned for the old goal minus the old-goal estimate of the new goal
+ * is still a lower bound, so changing goals costs nothing up front.
+ *
+ * Learned values only hold while step costs do not drop, so they are forgotten when the
+ * level, the blocker mask or any blocker changes (an enemy defeated or teleported away), and
+ * when the goal is a blocked cell (an enemy) that earlier searches could not enter.
+ * Worker copies of one level's grid share what was learned on any of them.
+ */
+class AdaptiveSearch {
+public:
+    // Same contract as SearchGrid::findPath; weight > 1 inflates the heuristic like SearchMode::Weighted.
+    std::vector<int> findPath(const SearchGrid &grid, int start, int goal, uint8_t blockerMask,
+                              float weight = 1.0f);
+    void clear();
+
+    uint64_t getExpanded() const noexcept { return workspace.expanded; }
+    size_t getSearchCount() const noexcept { return searchCount - firstSearch + 1; }
+
+private:
+    float baseHeuristic(int cell) const noexcept;
+    float heuristic(int cell) const noexcept;
+    void learn(const std::vector<int> &closedCells, float pathCost, float weight);
+
+    const SearchGrid *grid = nullptr;
+    uint64_t blockerVersion = 0;
+    uint8_t mask = 0;
+    int goal = -1;
+    int exemptGoal = -1; // blocked goal every value since firstSearch was learned with open, or -1
+
+    SearchWorkspace workspace;
+    std::vector<int> closedCells;
+
+    // learned[c] is a lower bound on the distance from c to the goal of search learnedIn[c];
+    // the goals' moves since then are summed in goalShift (indexed by search number)
+    std::vector<float> learned;
+    std::vector<uint32_t> learnedIn;
+    std::vector<float> goalShift;
+    uint32_t searchCount = 0;
+    uint32_t firstSearch = 1; // values from searches before this one were cleared
+};
+
+#endif // ADAPTIVESEARCH_H
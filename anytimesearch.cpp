@@ -0,0 +1,155 @@
+#include "anytimesearch.h"
+#include "landmarks.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+// Expansions between clock reads; a read costs about as much as a few expansions
+constexpr int kClockStride = 64;
+}
+
+void AnytimeSearch::start(std::shared_ptr<SearchGrid> g, int start, int goal, uint8_t blockerMask)
+{
+    reset();
+    if (!g || start < 0 || start >= g->size() || goal < 0 || goal >= g->size()) return;
+
+    grid = std::move(g);
+    startCell = start;
+    goalCell = goal;
+    mask = blockerMask;
+
+    workspace.setOpenListKind(grid->getOpenListKind());
+    workspace.begin(grid->size());
+    workspace.reach(start, 0.0f, start);
+    workspace.f[start] = heuristic(start);
+    workspace.push(workspace.f[start], start);
+    bestCell = start;
+    bestH = workspace.f[start];
+    status = start == goal ? Status::Found : Status::Running;
+}
+
+void AnytimeSearch::reset()
+{
+    grid.reset();
+    status = Status::Idle;
+    startCell = -1;
+    goalCell = -1;
+    bestCell = -1;
+    expanded = 0;
+}
+
+float AnytimeSearch::heuristic(int cell) const noexcept
+{
+    int cols = grid->getCols();
+    if (const LandmarkTable *landmarks = grid->getLandmarks()) {
+        return LandmarkHeuristic{landmarks, cols, grid->getMinStepCost()}(cell, goalCell);
+    }
+    // Diagonals cost the same as straight steps, so this is the admissible octile distance
+    int dx = std::abs(cell % cols - goalCell % cols);
+    int dy = std::abs(cell / cols - goalCell / cols);
+    return grid->getMinStepCost() * static_cast<float>(std::max(dx, dy));
+}
+
+AnytimeSearch::Status AnytimeSearch::run(std::chrono::microseconds budget)
+{
+    if (status != Status::Running) return status;
+
+    const SearchGrid &g = *grid;
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    for (int sinceClock = 0; ; ++sinceClock) {
+        if (sinceClock == kClockStride) {
+            if (std::chrono::steady_clock::now() >= deadline) return status;
+            sinceClock = 0;
+        }
+        if (workspace.openEmpty()) {
+            status = Status::NoPath;
+            return status;
+        }
+
+        SearchWorkspace::OpenEntry current = workspace.pop();
+        if (current.f > workspace.f[current.index]) continue;
+        ++expanded;
+
+        float h = current.f - workspace.g[current.index];
+        if (h < bestH || (h == bestH && workspace.g[current.index] < workspace.g[bestCell])) {
+            bestH = h;
+            bestCell = current.index;
+        }
+        if (current.index == goalCell) {
+            bestCell = goalCell;
+            status = Status::Found;
+            return status;
+        }
+
+        int cx = g.xOf(current.index);
+        int cy = g.yOf(current.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!g.inBounds(nx, ny)) continue;
+
+            int next = g.index(nx, ny);
+            float step = next == goalCell ? g.getStepCost(next) : g.getStepCost(next, mask);
+            if (step == std::numeric_limits<float>::infinity()) continue;
+
+            float newG = workspace.g[current.index] + step;
+            if (workspace.isReached(next) && newG >= workspace.g[next]) continue;
+
+            workspace.reach(next, newG, current.index);
+            workspace.f[next] = newG + heuristic(next);
+            workspace.push(workspace.f[next], next);
+        }
+    }
+}
+
+std::vector<int> AnytimeSearch::bestCells() const
+{
+    std::vector<int> cells;
+    if (bestCell < 0) return cells;
+    for (int current = bestCell; current != startCell; current = static_cast<int>(workspace.parent[current])) {
+        cells.push_back(current);
+    }
+    cells.push_back(startCell);
+    std::reverse(cells.begin(), cells.end());
+    return cells;
+}
+
+std::vector<int> AnytimeSearch::bestPath() const
+{
+    std::vector<int> cells = bestCells();
+    std::vector<int> path;
+    for (size_t i = 1; i < cells.size(); ++i) {
+        path.push_back(SearchGrid::directionBetween(grid->xOf(cells[i-1]), grid->yOf(cells[i-1]),
+                                                    grid->xOf(cells[i]), grid->yOf(cells[i])));
+    }
+    return path;
+}
+
+std::vector<int> AnytimeSearch::continuationFrom(const std::vector<int> &trail) const
+{
+    std::vector<int> cells = bestCells();
+    if (cells.empty() || trail.empty() || trail.front() != startCell) return {};
+
+    std::unordered_map<int, size_t> onPath;
+    for (size_t i = 0; i < cells.size(); ++i) onPath.emplace(cells[i], i);
+
+    // Last trail cell on the best path; trail[0] is the start, so there always is one
+    size_t join = trail.size() - 1;
+    while (onPath.find(trail[join]) == onPath.end()) --join;
+
+    std::vector<int> route;
+    route.reserve(trail.size() - 1 - join);
+    for (size_t i = trail.size() - 1; i > join; --i) route.push_back(trail[i-1]);
+    for (size_t i = onPath[trail[join]] + 1; i < cells.size(); ++i) route.push_back(cells[i]);
+
+    std::vector<int> path;
+    int current = trail.back();
+    for (int cell : route) {
+        path.push_back(SearchGrid::directionBetween(grid->xOf(current), grid->yOf(current),
+                                                    grid->xOf(cell), grid->yOf(cell)));
+        current = cell;
+    }
+    return path;
+}
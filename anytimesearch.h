@@ -0,0 +1,67 @@
+#ifndef ANYTIMESEARCH_H
+#define ANYTIMESEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief A* that runs in resumable, time-budgeted slices and can be walked before it finishes.
+ *
+ * Each run() expands cells until its microsecond budget is spent, then returns; the open
+ * list and parents stay in the search's own workspace, so the next slice carries on where
+ * the last one stopped. Between slices bestPath() is the route to the expanded cell closest
+ * to the goal by the heuristic (the goal itself once found), so the protagonist can start
+ * moving on a huge map right away while later slices refine the route.
+ *
+ * Runs on the GUI thread against the live grid, so blocker changes between slices are seen
+ * by the cells still to be expanded.
+ */
+class AnytimeSearch {
+public:
+    enum class Status { Idle, Running, Found, NoPath };
+
+    void start(std::shared_ptr<SearchGrid> grid, int start, int goal, uint8_t blockerMask);
+    // Expands cells until the budget is spent or the search ends.
+    Status run(std::chrono::microseconds budget);
+    void reset();
+
+    Status getStatus() const noexcept { return status; }
+    bool isRunning() const noexcept { return status == Status::Running; }
+    const SearchGrid* getGrid() const noexcept { return grid.get(); }
+    int getStart() const noexcept { return startCell; }
+    int getGoal() const noexcept { return goalCell; }
+    // Expanded cell with the lowest heuristic so far (ties to the cheaper one); the goal once found.
+    int getBestCell() const noexcept { return bestCell; }
+    size_t getExpanded() const noexcept { return expanded; }
+
+    // 0-7 directions from the start to getBestCell().
+    std::vector<int> bestPath() const;
+
+    /**
+     * @brief Directions from the end of trail (cells walked since the start, trail[0] == start)
+     * onto the current best path. If the best path no longer runs through where we stand, the
+     * trail is retraced back to the last cell the two share.
+     */
+    std::vector<int> continuationFrom(const std::vector<int> &trail) const;
+
+private:
+    float heuristic(int cell) const noexcept;
+    std::vector<int> bestCells() const;
+
+    std::shared_ptr<SearchGrid> grid;
+    SearchWorkspace workspace;
+    Status status = Status::Idle;
+    int startCell = -1;
+    int goalCell = -1;
+    uint8_t mask = 0;
+
+    int bestCell = -1;
+    float bestH = 0.0f;
+    size_t expanded = 0;
+};
+
+#endif // ANYTIMESEARCH_H
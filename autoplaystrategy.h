@@ -1,6 +1,7 @@
 #ifndef AUTOPLAYSTRATEGY_H
 #define AUTOPLAYSTRATEGY_H
 
+#include "searchgrid.h"
 #include <vector>
 
 class GameModel;
@@ -26,6 +27,13 @@ public:
     // If no move is needed (autoplay done or stuck), return {0,0} and handle that.
     virtual AutoPlayMove nextStep() = 0;
 
+    // True while a decision is still being planned (off the GUI thread); nextStep returns {0,0}
+    // meanwhile, which then means "wait", not "done".
+    virtual bool isPlanning() const { return false; }
+
+    // Expansions, path cost and time of the last decision (for "path stats"); empty if none ran
+    virtual SearchGrid::QueryStats getLastQuery() const { return {}; }
+
     // Decide next action: called when we need a new path or target after reaching a goal.
     virtual void decideNextAction() = 0;
 
@@ -0,0 +1,138 @@
+#include "bidirectionalsearch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+BidirectionalSearch::BidirectionalSearch(const SearchGrid &grid, SearchWorkspace &forward, SearchWorkspace &backward)
+    : grid(grid), fwd(forward), bwd(backward), start(-1), goal(-1), blockerMask(0), meeting(-1),
+      bestCost(std::numeric_limits<float>::infinity())
+{}
+
+float BidirectionalSearch::enterCost(int idx) const noexcept
+{
+    return idx == goal ? grid.getStepCost(idx) : grid.getStepCost(idx, blockerMask);
+}
+
+float BidirectionalSearch::heuristic(int from, int to) const noexcept
+{
+    // Every step pays at least the cheapest tile, diagonal or not
+    int dx = std::abs(grid.xOf(from) - grid.xOf(to));
+    int dy = std::abs(grid.yOf(from) - grid.yOf(to));
+    return grid.getMinStepCost() * static_cast<float>(std::max(dx, dy));
+}
+
+std::vector<int> BidirectionalSearch::findPath(int startIdx, int goalIdx, uint8_t mask)
+{
+    start = startIdx;
+    goal = goalIdx;
+    blockerMask = mask;
+    meeting = -1;
+    bestCost = std::numeric_limits<float>::infinity();
+    if (start == goal || enterCost(goal) == std::numeric_limits<float>::infinity()) {
+        return {};
+    }
+
+    fwd.begin(grid.size());
+    bwd.begin(grid.size());
+    fwd.reach(start, 0.0f, start);
+    fwd.f[start] = heuristic(start, goal);
+    fwd.push(fwd.f[start], start);
+    bwd.reach(goal, 0.0f, goal);
+    bwd.f[goal] = heuristic(goal, start);
+    bwd.push(bwd.f[goal], goal);
+
+    while (!fwd.openEmpty() && !bwd.openEmpty() && !grid.isCancelled()) {
+        // Any cheaper path would still have a cell on each open list with f below mu
+        if (bestCost <= std::max(fwd.openMinKey(), bwd.openMinKey())) break;
+        if (fwd.openSize() <= bwd.openSize()) {
+            expandForward();
+        } else {
+            expandBackward();
+        }
+    }
+    if (grid.isCancelled()) return {};
+
+    // One side ran out of cells without touching the other: it is sealed off. If they did
+    // touch, the side that ran out has already settled every path, so mu is optimal too
+    return meeting < 0 ? std::vector<int>() : joinPaths();
+}
+
+void BidirectionalSearch::expandForward()
+{
+    SearchWorkspace::OpenEntry current = fwd.pop();
+    if (current.f > fwd.f[current.index]) return;
+    ++fwd.expanded;
+
+    int cx = grid.xOf(current.index);
+    int cy = grid.yOf(current.index);
+    for (int d = 0; d < 8; ++d) {
+        int nx = cx + SearchGrid::dirDx[d];
+        int ny = cy + SearchGrid::dirDy[d];
+        if (!grid.inBounds(nx, ny)) continue;
+
+        int next = grid.index(nx, ny);
+        float step = enterCost(next);
+        if (step == std::numeric_limits<float>::infinity()) continue;
+
+        float newG = fwd.g[current.index] + step;
+        if (fwd.isReached(next) && newG >= fwd.g[next]) continue;
+
+        fwd.reach(next, newG, current.index);
+        if (bwd.isReached(next) && newG + bwd.g[next] < bestCost) {
+            bestCost = newG + bwd.g[next];
+            meeting = next;
+        }
+        fwd.f[next] = newG + heuristic(next, goal);
+        fwd.push(fwd.f[next], next);
+    }
+}
+
+void BidirectionalSearch::expandBackward()
+{
+    SearchWorkspace::OpenEntry current = bwd.pop();
+    if (current.f > bwd.f[current.index]) return;
+    ++bwd.expanded;
+
+    // Stepping from a predecessor onto the current cell pays the current cell's cost
+    float step = enterCost(current.index);
+    int cx = grid.xOf(current.index);
+    int cy = grid.yOf(current.index);
+    for (int d = 0; d < 8; ++d) {
+        int px = cx + SearchGrid::dirDx[d];
+        int py = cy + SearchGrid::dirDy[d];
+        if (!grid.inBounds(px, py)) continue;
+
+        int prev = grid.index(px, py);
+        if (prev != start && enterCost(prev) == std::numeric_limits<float>::infinity()) continue;
+
+        float newG = bwd.g[current.index] + step;
+        if (bwd.isReached(prev) && newG >= bwd.g[prev]) continue;
+
+        bwd.reach(prev, newG, current.index);
+        if (fwd.isReached(prev) && fwd.g[prev] + newG < bestCost) {
+            bestCost = fwd.g[prev] + newG;
+            meeting = prev;
+        }
+        bwd.f[prev] = newG + heuristic(prev, start);
+        bwd.push(bwd.f[prev], prev);
+    }
+}
+
+std::vector<int> BidirectionalSearch::joinPaths() const
+{
+    std::vector<int> path;
+    for (int current = meeting; current != start; ) {
+        int prev = static_cast<int>(fwd.parent[current]);
+        path.push_back(SearchGrid::directionBetween(grid.xOf(prev), grid.yOf(prev), grid.xOf(current), grid.yOf(current)));
+        current = prev;
+    }
+    std::reverse(path.begin(), path.end());
+
+    // Backward parents point one step closer to the goal
+    for (int current = meeting; current != goal; ) {
+        int next = static_cast<int>(bwd.parent[current]);
+        path.push_back(SearchGrid::directionBetween(grid.xOf(current), grid.yOf(current), grid.xOf(next), grid.yOf(next)));
+        current = next;
+    }
+    return path;
+}
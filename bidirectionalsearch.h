@@ -0,0 +1,43 @@
+#ifndef BIDIRECTIONALSEARCH_H
+#define BIDIRECTIONALSEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Bidirectional A*: one frontier grows from the start, one backwards from the goal.
+ *
+ * Each iteration expands the smaller frontier and keeps the cheapest start-to-goal cost
+ * mu seen where the frontiers touch. Both heuristics are the Chebyshev distance times the
+ * cheapest step, so once mu is no larger than either frontier's smallest f no unexplored
+ * path can beat it and the search stops with an optimal path. It also stops as soon as
+ * either frontier runs dry, which is how unreachable goals in a sealed region are
+ * reported without flooding the start's region.
+ */
+class BidirectionalSearch {
+public:
+    BidirectionalSearch(const SearchGrid &grid, SearchWorkspace &forward, SearchWorkspace &backward);
+
+    // Same contract as SearchGrid::findPath: 0-7 directions, empty if unreachable.
+    std::vector<int> findPath(int start, int goal, uint8_t blockerMask);
+
+private:
+    float enterCost(int idx) const noexcept;
+    float heuristic(int from, int to) const noexcept;
+    void expandForward();
+    void expandBackward();
+    std::vector<int> joinPaths() const;
+
+    const SearchGrid &grid;
+    SearchWorkspace &fwd;
+    SearchWorkspace &bwd;
+    int start;
+    int goal;
+    uint8_t blockerMask;
+    int meeting;
+    float bestCost; // mu: cheapest path through a cell both frontiers reached
+};
+
+#endif // BIDIRECTIONALSEARCH_H
@@ -0,0 +1,139 @@
+#ifndef BUCKETQUEUE_H
+#define BUCKETQUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Monotone bucket queue over quantized f-values (Dial's algorithm), the alternative
+ *        open list of SearchWorkspace.
+ *
+ * f is cut into buckets of width 1/keyScale kept in a ring; push and pop are O(1) with no
+ * comparisons. Entries inside one bucket come out in LIFO order. Because the width is
+ * below the cheapest tile step (0.05), a Dijkstra flood still settles every cell at its
+ * exact distance; an A* path with an admissible heuristic costs at most one bucket width
+ * more than the optimum.
+ *
+ * Entries keyed below the current bucket, which an inconsistent heuristic (such as the
+ * Euclidean one the benchmark compares against) produces all the time, go to a small binary heap that is drained first, so such searches
+ * keep the exact heap order. Keys beyond the ring wait in an overflow heap and move into the
+ * ring as soon as the cursor advances far enough for them to fit.
+ */
+class BucketQueue {
+public:
+    struct Entry {
+        float f;
+        int index;
+    };
+
+    static constexpr float keyScale = 64.0f;
+    static constexpr uint64_t ringSize = 256; // power of two; spans f + 4
+
+    void clear()
+    {
+        if (ringCount > 0) {
+            for (auto &bucket : ring) bucket.clear();
+        }
+        below.clear();
+        overflow.clear();
+        cursor = 0;
+        count = 0;
+        ringCount = 0;
+        anchored = false;
+    }
+
+    bool empty() const noexcept { return count == 0; }
+    size_t size() const noexcept { return count; }
+
+    // Smallest f waiting, without popping; the queue must not be empty
+    float minKey() const
+    {
+        if (!below.empty()) return below.front().f;
+        if (ringCount == 0) return overflow.front().f;
+        uint64_t key = cursor;
+        while (ring[key & (ringSize - 1)].empty()) ++key;
+        const std::vector<Entry> &bucket = ring[key & (ringSize - 1)];
+        float lowest = bucket.front().f;
+        for (const Entry &e : bucket) lowest = std::min(lowest, e.f);
+        return lowest;
+    }
+
+    void push(float f, int index)
+    {
+        ++count;
+        place({f, index});
+    }
+
+    Entry pop()
+    {
+        --count;
+        if (!below.empty()) {
+            std::pop_heap(below.begin(), below.end(), belowOrder);
+            Entry top = below.back();
+            below.pop_back();
+            return top;
+        }
+
+        if (ringCount == 0) {
+            // Ring exhausted: restart it at the smallest waiting entry
+            cursor = keyOf(overflow.front().f);
+        } else {
+            while (ring[cursor & (ringSize - 1)].empty()) ++cursor;
+        }
+        // The ring now reaches further; waiting entries that fit must be ordered with the rest
+        while (!overflow.empty() && keyOf(overflow.front().f) - cursor < ringSize) {
+            std::pop_heap(overflow.begin(), overflow.end(), belowOrder);
+            Entry e = overflow.back();
+            overflow.pop_back();
+            ring[keyOf(e.f) & (ringSize - 1)].push_back(e);
+            ++ringCount;
+        }
+
+        std::vector<Entry> &bucket = ring[cursor & (ringSize - 1)];
+        Entry top = bucket.back();
+        bucket.pop_back();
+        --ringCount;
+        return top;
+    }
+
+private:
+    static uint64_t keyOf(float f) noexcept
+    {
+        constexpr float maxF = 1.0e15f;
+        return static_cast<uint64_t>(std::clamp(f, 0.0f, maxF) * keyScale);
+    }
+
+    void place(const Entry &e)
+    {
+        uint64_t key = keyOf(e.f);
+        if (!anchored) {
+            cursor = key;
+            anchored = true;
+        }
+        if (key < cursor) {
+            below.push_back(e);
+            std::push_heap(below.begin(), below.end(), belowOrder);
+            return;
+        }
+        if (key - cursor >= ringSize) {
+            overflow.push_back(e);
+            std::push_heap(overflow.begin(), overflow.end(), belowOrder);
+            return;
+        }
+        ring[key & (ringSize - 1)].push_back(e);
+        ++ringCount;
+    }
+
+    static bool belowOrder(const Entry &a, const Entry &b) { return a.f > b.f; }
+
+    std::vector<Entry> ring[ringSize];
+    std::vector<Entry> below;    // binary heap, f below the current bucket
+    std::vector<Entry> overflow; // binary heap, f at least one ring span above the cursor
+    uint64_t cursor = 0;
+    size_t count = 0;
+    size_t ringCount = 0;
+    bool anchored = false;
+};
+
+#endif // BUCKETQUEUE_H
@@ -20,8 +20,14 @@
  *  - left
  *  - right
  *  - goto x y
+ *  - goto level x y
  *  - attack nearest enemy
  *  - take nearest health pack
+ *  - path stats
+ *  - queue [heap|bucket]
+ *  - anytime [off|microseconds]
+ *  - danger [off|weight]
+ *  - search [goto|auto] epsilon [focal]
  *  - help
  */
 class CommandParser {
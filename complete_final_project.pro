@@ -9,30 +9,81 @@ CONFIG += c++20
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    adaptivesearch.cpp \
+    anytimesearch.cpp \
+    bidirectionalsearch.cpp \
+    compressedpathdatabase.cpp \
+    cooperativeplanner.cpp \
     defaultautoplaystrategy.cpp \
+    distancemap.cpp \
+    dstarlite.cpp \
+    flowfield.cpp \
+    focalsearch.cpp \
     gamecontroller.cpp \
     gamemodel.cpp \
     gamestatemanager.cpp \
     gameview.cpp \
+    hierarchicalgraph.cpp \
+    influencemap.cpp \
+    jumppointsearch.cpp \
+    landmarks.cpp \
     main.cpp \
     mainwindow.cpp \
+    partysimulation.cpp \
+    pathbenchmark.cpp \
+    pathcache.cpp \
+    pathdatabasetool.cpp \
+    pathplanningservice.cpp \
+    poidistancematrix.cpp \
+    portalgraph.cpp \
+    regionlabels.cpp \
+    resourcesearch.cpp \
+    routeplanner.cpp \
+    searchgrid.cpp \
     textgameview.cpp
 
 HEADERS += \
+    adaptivesearch.h \
+    anytimesearch.h \
     autoplaystrategy.h \
+    bidirectionalsearch.h \
+    bucketqueue.h \
     commandparser.h \
+    compressedpathdatabase.h \
+    cooperativeplanner.h \
     defaultautoplaystrategy.h \
+    distancemap.h \
+    dstarlite.h \
     enemy.h \
+    flowfield.h \
+    focalsearch.h \
     gamecontroller.h \
     gamemodel.h \
     gamestatemanager.h \
     gameview.h \
     healthpack.h \
+    hierarchicalgraph.h \
+    influencemap.h \
+    jumppointsearch.h \
+    landmarks.h \
     mainwindow.h \
     node.h \
+    partysimulation.h \
+    pathbenchmark.h \
+    pathcache.h \
+    pathdatabasetool.h \
+    pathplanningservice.h \
     penemy.h \
+    poidistancematrix.h \
     portal.h \
+    portalgraph.h \
     protagonist.h \
+    regionlabels.h \
+    resourcesearch.h \
+    routeplanner.h \
+    searchgrid.h \
+    searchkernels.h \
+    searchworkspace.h \
     textgameview.h \
     tile.h \
     xenemy.h
@@ -0,0 +1,219 @@
+#include "compressedpathdatabase.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace {
+constexpr quint32 kMagic = 0x43504431; // "CPD1"
+constexpr quint32 kFormatVersion = 1;
+}
+
+CompressedPathDatabase::CompressedPathDatabase(const SearchGrid &grid, const std::function<void(int, int)> &progress)
+    : rows(grid.getRows()), cols(grid.getCols()), cells(grid.size()), fingerprint(fingerprintOf(grid))
+{
+    // One Dijkstra per source, each thread encoding its rows into their own vectors
+    std::vector<std::vector<uint32_t>> encoded(cells);
+    std::atomic<int> nextSource(0);
+    std::atomic<int> done(0);
+    auto worker = [this, &grid, &encoded, &nextSource, &done, &progress](bool report) {
+        SearchWorkspace ws;
+        ws.setOpenListKind(OpenListKind::BinaryHeap); // exact ordering; buckets quantize costs
+        std::vector<uint8_t> moves;
+        for (int source = nextSource++; source < cells; source = nextSource++) {
+            if (grid.isPassable(source)) {
+                moves.assign(cells, noMove);
+                ws.begin(cells);
+                ws.reach(source, 0.0f, source);
+                ws.push(0.0f, source);
+                while (!ws.openEmpty()) {
+                    SearchWorkspace::OpenEntry current = ws.pop();
+                    if (current.f > ws.g[current.index]) continue;
+
+                    int cx = grid.xOf(current.index);
+                    int cy = grid.yOf(current.index);
+                    for (int d = 0; d < 8; ++d) {
+                        int nx = cx + SearchGrid::dirDx[d];
+                        int ny = cy + SearchGrid::dirDy[d];
+                        if (!grid.inBounds(nx, ny)) continue;
+
+                        int next = grid.index(nx, ny);
+                        float step = grid.getStepCost(next);
+                        if (step == std::numeric_limits<float>::infinity()) continue;
+
+                        float newG = ws.g[current.index] + step;
+                        if (ws.isReached(next) && newG >= ws.g[next]) continue;
+
+                        ws.reach(next, newG, current.index);
+                        // Settled cells pass their first move on; the source's neighbours start one
+                        moves[next] = current.index == source ? static_cast<uint8_t>(d) : moves[current.index];
+                        ws.push(newG, next);
+                    }
+                }
+                encodeRow(grid, source, moves, encoded[source]);
+            }
+            int finished = ++done;
+            if (report && progress) progress(finished, cells);
+        }
+    };
+
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker, false);
+    }
+    worker(true);
+    for (auto &t : threads) t.join();
+    if (progress) progress(cells, cells);
+
+    rowStart.reserve(static_cast<size_t>(cells) + 1);
+    rowStart.push_back(0);
+    for (auto &row : encoded) {
+        runs.insert(runs.end(), row.begin(), row.end());
+        rowStart.push_back(static_cast<uint32_t>(runs.size()));
+        std::vector<uint32_t>().swap(row);
+    }
+}
+
+void CompressedPathDatabase::encodeRow(const SearchGrid &grid, int source, const std::vector<uint8_t> &moves,
+                                       std::vector<uint32_t> &row) const
+{
+    uint8_t current = anyMove;
+    for (int target = 0; target < cells; ++target) {
+        uint8_t move = (target == source || !grid.isPassable(target)) ? anyMove : moves[target];
+        if (move == anyMove || move == current) continue;
+        // Leading walls join the first run
+        uint32_t first = current == anyMove ? 0u : static_cast<uint32_t>(target);
+        row.push_back(first << 4 | move);
+        current = move;
+    }
+    if (row.empty()) row.push_back(noMove); // nothing reachable from this cell
+}
+
+int CompressedPathDatabase::firstMove(int source, int target) const noexcept
+{
+    if (source < 0 || source >= cells || target < 0 || target >= cells) return -1;
+    auto begin = runs.begin() + rowStart[source];
+    auto end = runs.begin() + rowStart[source + 1];
+    // Last run starting at or before target
+    auto it = std::upper_bound(begin, end, static_cast<uint32_t>(target) << 4 | 15u);
+    if (it == begin) return -1;
+    uint32_t move = *(it - 1) & 15u;
+    return move < noMove ? static_cast<int>(move) : -1;
+}
+
+CompressedPathDatabase::Lookup CompressedPathDatabase::extractPath(const SearchGrid &grid, int start, int goal,
+                                                                   uint8_t blockerMask, std::vector<int> &path) const
+{
+    if (grid.size() != cells || start < 0 || start >= cells || goal < 0 || goal >= cells) return Lookup::NoPath;
+    if (!grid.isPassable(start) || !grid.isPassable(goal)) return Lookup::NoPath;
+
+    size_t first = path.size();
+    int current = start;
+    while (current != goal) {
+        int d = firstMove(current, goal);
+        if (d < 0) {
+            path.resize(first);
+            return Lookup::NoPath;
+        }
+        int next = grid.index(grid.xOf(current) + SearchGrid::dirDx[d], grid.yOf(current) + SearchGrid::dirDy[d]);
+        // Too long means equal-cost moves went in circles; let the caller search
+        if ((next != goal && grid.isBlocked(next, blockerMask)) || path.size() - first >= static_cast<size_t>(cells)) {
+            path.resize(first);
+            return Lookup::Blocked;
+        }
+        path.push_back(d);
+        current = next;
+    }
+    return Lookup::Found;
+}
+
+uint64_t CompressedPathDatabase::fingerprintOf(const SearchGrid &grid)
+{
+    // FNV-1a over the dimensions and the bits of every step cost
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (value >> (8 * i)) & 0xffu;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(static_cast<uint32_t>(grid.getRows()));
+    mix(static_cast<uint32_t>(grid.getCols()));
+    for (int i = 0; i < grid.size(); ++i) {
+        float cost = grid.getStepCost(i);
+        uint32_t bits;
+        std::memcpy(&bits, &cost, sizeof(bits));
+        mix(bits);
+    }
+    return hash;
+}
+
+bool CompressedPathDatabase::save(const QString &file) const
+{
+    QFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&f);
+    out << kMagic << kFormatVersion << qint32(rows) << qint32(cols) << quint64(fingerprint)
+        << quint32(rowStart.size()) << quint32(runs.size());
+    for (uint32_t offset : rowStart) out << quint32(offset);
+    for (uint32_t run : runs) out << quint32(run);
+    return out.status() == QDataStream::Ok;
+}
+
+std::shared_ptr<const CompressedPathDatabase> CompressedPathDatabase::load(const QString &file, const SearchGrid &grid)
+{
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) return nullptr;
+    QDataStream in(&f);
+
+    quint32 magic = 0, version = 0, rowStartCount = 0, runCount = 0;
+    qint32 r = 0, c = 0;
+    quint64 print = 0;
+    in >> magic >> version >> r >> c >> print >> rowStartCount >> runCount;
+    if (in.status() != QDataStream::Ok || magic != kMagic || version != kFormatVersion) return nullptr;
+    // Built for another level, or for an older version of this one
+    if (r != grid.getRows() || c != grid.getCols() || print != fingerprintOf(grid)) return nullptr;
+    if (rowStartCount != static_cast<quint32>(grid.size()) + 1 || runCount > (f.size() / sizeof(quint32))) return nullptr;
+
+    std::shared_ptr<CompressedPathDatabase> db(new CompressedPathDatabase());
+    db->rows = r;
+    db->cols = c;
+    db->cells = grid.size();
+    db->fingerprint = print;
+    db->rowStart.resize(rowStartCount);
+    db->runs.resize(runCount);
+    for (uint32_t &offset : db->rowStart) {
+        quint32 v;
+        in >> v;
+        offset = v;
+    }
+    for (uint32_t &run : db->runs) {
+        quint32 v;
+        in >> v;
+        run = v;
+    }
+    if (in.status() != QDataStream::Ok) return nullptr;
+    for (size_t s = 0; s + 1 < db->rowStart.size(); ++s) {
+        if (db->rowStart[s] > db->rowStart[s + 1]) return nullptr;
+    }
+    if (db->rowStart.front() != 0 || db->rowStart.back() != runCount) return nullptr;
+    return db;
+}
+
+QString CompressedPathDatabase::fileFor(const QString &levelFile, const QString &dir)
+{
+    QString base = dir.isEmpty() ? defaultDir() : dir;
+    return QDir(base).filePath(QFileInfo(levelFile).completeBaseName() + ".cpd");
+}
+
+QString CompressedPathDatabase::defaultDir()
+{
+    return QCoreApplication::applicationDirPath() + "/pathdb";
+}
@@ -0,0 +1,75 @@
+#ifndef COMPRESSEDPATHDATABASE_H
+#define COMPRESSEDPATHDATABASE_H
+
+#include "searchgrid.h"
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Compressed path database (CPD): the first move of an optimal path between every pair of cells.
+ *
+ * Built offline (one Dijkstra per source over the static tile costs) by the
+ * --build-path-databases tool and loaded with the level. Each source's row of first
+ * moves is run-length encoded over the targets in row-major order; walls are
+ * "don't care" and extend whichever run they fall in, so rows on typical maps shrink
+ * to a few hundred runs. A first move is a binary search in one row, and a path is
+ * extracted by following first moves cell by cell, with no search at all.
+ *
+ * Only static costs are baked in. Blockers can only remove routes, so an extracted path
+ * that avoids them is still optimal; when it runs into one, the caller searches instead.
+ */
+class CompressedPathDatabase {
+public:
+    // Building is quadratic in the cell count; the tool skips larger levels unless told otherwise.
+    static constexpr int defaultMaxCells = 65536;
+
+    /**
+     * @brief Builds the table for grid's static costs on all cores.
+     * progress(done, total) is called on the calling thread as source rows complete.
+     */
+    explicit CompressedPathDatabase(const SearchGrid &grid, const std::function<void(int, int)> &progress = {});
+
+    // Reads a table written by save(); nullptr if missing, corrupt or built for other tiles.
+    static std::shared_ptr<const CompressedPathDatabase> load(const QString &file, const SearchGrid &grid);
+    bool save(const QString &file) const;
+    // Where the table of a level image is kept: <dir>/<image base name>.cpd, dir defaulting to defaultDir()
+    static QString fileFor(const QString &levelFile, const QString &dir = QString());
+    // pathdb/ next to the executable, where the game looks for tables
+    static QString defaultDir();
+
+    // 0-7 direction of an optimal first step from source to target; -1 if there is none.
+    int firstMove(int source, int target) const noexcept;
+
+    enum class Lookup { Found, NoPath, Blocked };
+    /**
+     * @brief Follows first moves from start to goal, appending 0-7 directions to path.
+     * Blocked if the path enters a cell (other than the goal) whose flags intersect blockerMask.
+     */
+    Lookup extractPath(const SearchGrid &grid, int start, int goal, uint8_t blockerMask, std::vector<int> &path) const;
+
+    int getCellCount() const noexcept { return cells; }
+    size_t getRunCount() const noexcept { return runs.size(); }
+    size_t getMemoryBytes() const noexcept { return runs.size() * sizeof(uint32_t) + rowStart.size() * sizeof(uint32_t); }
+
+private:
+    CompressedPathDatabase() = default;
+
+    // Identifies the tile costs a table was built for
+    static uint64_t fingerprintOf(const SearchGrid &grid);
+    void encodeRow(const SearchGrid &grid, int source, const std::vector<uint8_t> &moves, std::vector<uint32_t> &row) const;
+
+    static constexpr uint8_t noMove = 8;      // unreachable target
+    static constexpr uint8_t anyMove = 15;    // wall or the source itself: matches any run
+
+    int rows = 0;
+    int cols = 0;
+    int cells = 0;
+    uint64_t fingerprint = 0;
+    std::vector<uint32_t> rowStart; // runs of source s are [rowStart[s], rowStart[s+1])
+    std::vector<uint32_t> runs;     // first target of the run << 4 | move
+};
+
+#endif // COMPRESSEDPATHDATABASE_H
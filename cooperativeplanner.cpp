@@ -0,0 +1,278 @@
+#include "cooperativeplanner.h"
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+constexpr float kInf = std::numeric_limits<float>::infinity();
+}
+
+CooperativePlanner::CooperativePlanner(int window)
+    : window(std::max(1, window))
+{
+}
+
+int CooperativePlanner::addAgent(int cell)
+{
+    Agent agent;
+    agent.cell = cell;
+    agents.push_back(std::move(agent));
+    return static_cast<int>(agents.size()) - 1;
+}
+
+void CooperativePlanner::setGoal(int agent, int goal)
+{
+    if (agents[agent].goal == goal) return;
+    agents[agent].goal = goal;
+    agents[agent].dirty = true;
+}
+
+std::vector<int> CooperativePlanner::getPlan(int agent) const
+{
+    const Agent &a = agents[agent];
+    return std::vector<int>(a.plan.begin() + static_cast<std::ptrdiff_t>(std::min(a.planIndex, a.plan.size())), a.plan.end());
+}
+
+int CooperativePlanner::reservedBy(int cell, uint64_t time) const
+{
+    auto it = reservations.find(keyOf(cell, time));
+    return it == reservations.end() ? -1 : it->second;
+}
+
+void CooperativePlanner::reserve(int agent, int cell, uint64_t time)
+{
+    uint64_t key = keyOf(cell, time);
+    // First come keeps it: an agent that could not get out of the way does not evict the one planned before it
+    if (reservations.emplace(key, agent).second) agents[agent].reserved.push_back(key);
+}
+
+void CooperativePlanner::release(int agent)
+{
+    for (uint64_t key : agents[agent].reserved) {
+        auto it = reservations.find(key);
+        if (it != reservations.end() && it->second == agent) reservations.erase(it);
+    }
+    agents[agent].reserved.clear();
+}
+
+CooperativePlanner::GoalDistance::GoalDistance(int goal, int origin, uint8_t blockerMask, uint64_t blockerVersion)
+    : goal(goal), origin(origin), mask(blockerMask), version(blockerVersion)
+{
+    entries[goal] = {0.0f, false};
+    open.push_back({0.0f, goal});
+}
+
+float CooperativePlanner::GoalDistance::costFrom(const SearchGrid &grid, int cell)
+{
+    auto known = entries.find(cell);
+    if (known != entries.end() && known->second.closed) return known->second.g;
+
+    // Chebyshev steps times the cheapest step: consistent, so every closed cell's cost is exact
+    const float minStep = grid.getMinStepCost();
+    auto h = [&](int c) {
+        return minStep * static_cast<float>(std::max(std::abs(grid.xOf(c) - grid.xOf(origin)),
+                                                     std::abs(grid.yOf(c) - grid.yOf(origin))));
+    };
+    auto greater = std::greater<SearchWorkspace::OpenEntry>();
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), greater);
+        SearchWorkspace::OpenEntry current = open.back();
+        open.pop_back();
+        Entry &entry = entries[current.index];
+        if (entry.closed || current.f > entry.g + h(current.index)) continue;
+        entry.closed = true;
+        const float g = entry.g;
+
+        // Agents may step off a blocked cell but never through one; the goal is always open
+        if (current.index == goal || !grid.isBlocked(current.index, mask)) {
+            // Every neighbour reaches the goal by stepping onto this cell, paying its cost
+            float viaCell = g + grid.getStepCost(current.index);
+            int cx = grid.xOf(current.index);
+            int cy = grid.yOf(current.index);
+            for (int d = 0; d < 8; ++d) {
+                int nx = cx + SearchGrid::dirDx[d];
+                int ny = cy + SearchGrid::dirDy[d];
+                if (!grid.inBounds(nx, ny)) continue;
+                int next = grid.index(nx, ny);
+                if (!grid.isPassable(next)) continue;
+
+                auto it = entries.find(next);
+                if (it != entries.end() && (it->second.closed || viaCell >= it->second.g)) continue;
+                entries[next] = {viaCell, false};
+                open.push_back({viaCell + h(next), next});
+                std::push_heap(open.begin(), open.end(), greater);
+            }
+        }
+        if (current.index == cell) return g;
+    }
+    return kInf;
+}
+
+CooperativePlanner::GoalDistance& CooperativePlanner::distanceTo(const SearchGrid &grid, int goal, int origin,
+                                                                 uint8_t blockerMask)
+{
+    std::unique_ptr<GoalDistance> &distance = heuristics[goal];
+    if (!distance || !distance->isFor(blockerMask, grid.getBlockerVersion())) {
+        distance = std::make_unique<GoalDistance>(goal, origin, blockerMask, grid.getBlockerVersion());
+    }
+    return *distance;
+}
+
+void CooperativePlanner::tick(const SearchGrid &grid, uint8_t blockerMask)
+{
+    lastTick = TickStats();
+    int count = getAgentCount();
+
+    if (now >= nextFullPlan && count > 0) {
+        // Everyone replans from scratch, starting one agent further down the list than last time
+        reservations.clear();
+        for (int i = 0; i < count; ++i) {
+            agents[i].reserved.clear();
+            reserve(i, agents[i].cell, now);
+        }
+        if (stuckAgent >= 0) firstPriority = static_cast<size_t>(stuckAgent);
+        stuckAgent = -1;
+        nextFullPlan = now + std::max(1, window / 2);
+        for (int k = 0; k < count; ++k) {
+            planAgent(grid, static_cast<int>((firstPriority + k) % count), blockerMask);
+        }
+        firstPriority = (firstPriority + 1) % count;
+
+        // Fields of goals nobody heads for any more
+        for (auto it = heuristics.begin(); it != heuristics.end();) {
+            bool used = std::any_of(agents.begin(), agents.end(), [&](const Agent &a) { return a.goal == it->first; });
+            it = used ? std::next(it) : heuristics.erase(it);
+        }
+    } else {
+        for (int i = 0; i < count; ++i) {
+            if (agents[i].dirty) planAgent(grid, i, blockerMask);
+        }
+    }
+
+    for (Agent &a : agents) {
+        if (a.planIndex < a.plan.size()) a.cell = a.plan[a.planIndex++];
+    }
+    ++now;
+}
+
+void CooperativePlanner::planAgent(const SearchGrid &grid, int agent, uint8_t blockerMask)
+{
+    release(agent);
+    Agent &a = agents[agent];
+    a.plan.clear();
+    a.planIndex = 0;
+    a.dirty = false;
+    ++lastTick.planned;
+    reserve(agent, a.cell, now);
+
+    const int start = a.cell;
+    const bool hasGoal = a.goal >= 0 && a.goal < grid.size() && grid.isPassable(a.goal);
+    const FlowField *field = sharedField;
+    if (!hasGoal || !field || !field->isReady() || field->getGoal() != a.goal || field->getBlockerMask() != blockerMask
+        || field->getBlockerVersion() != grid.getBlockerVersion()) {
+        field = nullptr;
+    }
+    GoalDistance *distance = hasGoal && !field ? &distanceTo(grid, a.goal, start, blockerMask) : nullptr;
+    auto goalCost = [&](int cell) { return field ? field->costToGoal(cell) : distance->costFrom(grid, cell); };
+    // Agents with no (reachable) goal stay where they are, but still step aside for the others
+    const bool guided = (field || distance) && goalCost(start) != kInf;
+    const int goal = guided ? a.goal : start;
+    const float minStep = grid.getMinStepCost();
+    auto heuristic = [&](int cell) {
+        if (guided) return goalCost(cell);
+        int dx = std::abs(grid.xOf(cell) - grid.xOf(goal));
+        int dy = std::abs(grid.yOf(cell) - grid.yOf(goal));
+        return minStep * static_cast<float>(std::max(dx, dy));
+    };
+
+    std::vector<int> cells; // one per tick of the window
+    const float waitCost = std::max(minStep, 1.0e-6f);
+    auto freeFrom = [&](int cell, int t) {
+        for (int u = t; u <= window; ++u) {
+            int holder = reservedBy(cell, now + u);
+            if (holder >= 0 && holder != agent) return false;
+        }
+        return true;
+    };
+    auto later = [](const OpenState &x, const OpenState &y) {
+        // Equal f: prefer the state further along in time
+        return x.f > y.f || (x.f == y.f && (x.key >> 32) < (y.key >> 32));
+    };
+
+    states.clear();
+    open.clear();
+    uint64_t startKey = keyOf(start, 0);
+    states[startKey] = {0.0f, startKey};
+    open.push_back({heuristic(start), startKey});
+
+    uint64_t endKey = 0;
+    bool found = false;
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), later);
+        OpenState current = open.back();
+        open.pop_back();
+        const StateRecord record = states[current.key];
+        int cell = static_cast<int>(current.key & 0xffffffffu);
+        int t = static_cast<int>(current.key >> 32);
+        if (current.f > record.g + heuristic(cell)) continue;
+        ++lastTick.expanded;
+
+        // The window is used up, or we can stay on the goal until it is
+        if (t == window || (cell == goal && freeFrom(goal, t))) {
+            endKey = current.key;
+            found = true;
+            break;
+        }
+
+        int cx = grid.xOf(cell);
+        int cy = grid.yOf(cell);
+        for (int d = -1; d < 8; ++d) {
+            int next = cell;
+            float step = waitCost;
+            if (d >= 0) {
+                int nx = cx + SearchGrid::dirDx[d];
+                int ny = cy + SearchGrid::dirDy[d];
+                if (!grid.inBounds(nx, ny)) continue;
+                next = grid.index(nx, ny);
+                step = next == goal ? grid.getStepCost(next) : grid.getStepCost(next, blockerMask);
+                if (step == kInf) continue;
+            }
+            int holder = reservedBy(next, now + t + 1);
+            if (holder >= 0 && holder != agent) continue;
+            // No swapping places with the agent that holds next right now
+            int facing = reservedBy(next, now + t);
+            if (d >= 0 && facing >= 0 && facing != agent && reservedBy(cell, now + t + 1) == facing) continue;
+
+            float h = heuristic(next);
+            if (h == kInf) continue;
+            float g = record.g + step;
+            uint64_t nextKey = keyOf(next, static_cast<uint64_t>(t + 1));
+            auto seen = states.find(nextKey);
+            if (seen != states.end() && g >= seen->second.g) continue;
+            states[nextKey] = {g, current.key};
+            open.push_back({g + h, nextKey});
+            std::push_heap(open.begin(), open.end(), later);
+        }
+    }
+
+    if (found) {
+        for (uint64_t key = endKey; key != startKey; key = states[key].parent) {
+            cells.push_back(static_cast<int>(key & 0xffffffffu));
+        }
+        std::reverse(cells.begin(), cells.end());
+    } else {
+        // Boxed in by agents planned earlier: everyone replans next tick with this one first
+        ++lastTick.stuck;
+        nextFullPlan = now + 1;
+        stuckAgent = agent;
+    }
+
+    // Hold the last cell for the rest of the window
+    int last = cells.empty() ? start : cells.back();
+    while (static_cast<int>(cells.size()) < window) cells.push_back(last);
+    for (int t = 0; t < window; ++t) {
+        reserve(agent, cells[t], now + t + 1);
+    }
+    a.plan = std::move(cells);
+}
@@ -0,0 +1,125 @@
+#ifndef COOPERATIVEPLANNER_H
+#define COOPERATIVEPLANNER_H
+
+#include "searchgrid.h"
+#include "flowfield.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Windowed hierarchical cooperative A* (WHCA*) for several agents on one level.
+ *
+ * Agents are planned one after another in priority order. Each plan is a space-time A*
+ * over (cell, tick) for the next `window` ticks, with waiting as a ninth move, and it is
+ * written into a reservation table that later agents must respect: no two agents on a
+ * cell at the same tick, and no two agents swapping cells between ticks. Beyond the window
+ * the search is guided by the true cost to the agent's goal, so agents head the right way
+ * even though they only coordinate for the next few ticks. That cost comes from a reverse
+ * resumable A* per goal (GoalDistance), shared by every agent with that goal and expanded
+ * only as far as their searches ask, or from a FlowField the caller shares for its goal.
+ *
+ * Every window/2 ticks all agents are replanned with the priorities rotated, so no agent
+ * keeps yielding to the same neighbours; an agent boxed in by earlier plans forces a full
+ * replan on the next tick with itself first. An agent whose goal changes replans right away
+ * against the others' current reservations.
+ */
+class CooperativePlanner {
+public:
+    static constexpr int defaultWindow = 16;
+
+    explicit CooperativePlanner(int window = defaultWindow);
+
+    // Adds an agent standing on cell; returns its id.
+    int addAgent(int cell);
+    // Where the agent heads; -1 holds its position.
+    void setGoal(int agent, int goal);
+    int getGoal(int agent) const { return agents[agent].goal; }
+    int getCell(int agent) const { return agents[agent].cell; }
+    int getAgentCount() const noexcept { return static_cast<int>(agents.size()); }
+    // Agents heading for field's published goal take their costs from it instead of a GoalDistance,
+    // while it was flooded on the grid and blockers tick() gets; nullptr detaches it.
+    void setSharedField(const FlowField *field) noexcept { sharedField = field; }
+    // Cells the agent will occupy over the coming ticks, from its last plan.
+    std::vector<int> getPlan(int agent) const;
+
+    /**
+     * @brief Plans whoever is due, then moves every agent one step.
+     * Paths avoid blocked cells (blockerMask) except each agent's own goal.
+     */
+    void tick(const SearchGrid &grid, uint8_t blockerMask);
+
+    struct TickStats {
+        int planned = 0;        // agents (re)planned this tick
+        uint64_t expanded = 0;  // space-time states expanded
+        int stuck = 0;          // agents that found no way through the reservations and held still
+    };
+    const TickStats& getLastTick() const noexcept { return lastTick; }
+
+private:
+    struct Agent {
+        int cell;
+        int goal = -1;
+        std::vector<int> plan;        // cells for ticks now+1 .. now+window
+        size_t planIndex = 0;
+        std::vector<uint64_t> reserved; // reservation keys held by this agent
+        bool dirty = true;
+    };
+
+    static uint64_t keyOf(int cell, uint64_t time) noexcept { return time << 32 | static_cast<uint32_t>(cell); }
+    int reservedBy(int cell, uint64_t time) const;
+    void reserve(int agent, int cell, uint64_t time);
+    void release(int agent);
+
+    // Reverse resumable A* from one goal: exact costs to it, expanded on demand
+    class GoalDistance {
+    public:
+        GoalDistance(int goal, int origin, uint8_t blockerMask, uint64_t blockerVersion);
+        float costFrom(const SearchGrid &grid, int cell);
+        bool isFor(uint8_t blockerMask, uint64_t blockerVersion) const noexcept {
+            return mask == blockerMask && version == blockerVersion;
+        }
+
+    private:
+        struct Entry {
+            float g;
+            bool closed;
+        };
+        int goal;
+        int origin; // the reverse search heads here first
+        uint8_t mask;
+        uint64_t version;
+        std::unordered_map<int, Entry> entries; // sized by what was explored, not by the level
+        std::vector<SearchWorkspace::OpenEntry> open;
+    };
+
+    void planAgent(const SearchGrid &grid, int agent, uint8_t blockerMask);
+    GoalDistance& distanceTo(const SearchGrid &grid, int goal, int origin, uint8_t blockerMask);
+
+    int window;
+    uint64_t now = 0;
+    uint64_t nextFullPlan = 0;
+    size_t firstPriority = 0;
+    int stuckAgent = -1; // goes first in the next full replan
+    std::vector<Agent> agents;
+    std::unordered_map<uint64_t, int> reservations; // (tick, cell) -> agent
+    std::unordered_map<int, std::unique_ptr<GoalDistance>> heuristics; // by goal cell
+    const FlowField *sharedField = nullptr;
+
+    // Space-time search state, reused between agents
+    struct StateRecord {
+        float g;
+        uint64_t parent;
+    };
+    struct OpenState {
+        float f;
+        uint64_t key; // tick within the window << 32 | cell
+    };
+    std::unordered_map<uint64_t, StateRecord> states;
+    std::vector<OpenState> open;
+
+    TickStats lastTick;
+};
+
+#endif // COOPERATIVEPLANNER_H
@@ -6,23 +6,54 @@
 #include "xenemy.h"
 #include "healthpack.h"
 #include "portal.h"
+#include "pathplanningservice.h"
+#include <chrono>
 #include <cmath>
 #include <limits>
 #include <random>
 
+namespace {
+// handlePEnemyPoison hits the protagonist standing on the defeated PEnemy's own tile
+constexpr float kPoisonDamage = 5.0f;
+
+float pathCost(const SearchGrid &grid, int start, const std::vector<int> &path)
+{
+    int x = grid.xOf(start);
+    int y = grid.yOf(start);
+    float cost = 0.0f;
+    for (int d : path) {
+        x += SearchGrid::dirDx[d];
+        y += SearchGrid::dirDy[d];
+        cost += grid.getStepCost(grid.index(x, y));
+    }
+    return cost;
+}
+}
+
 void DefaultAutoPlayStrategy::start(GameModel *m) {
     model = m;
     autoPath.clear();
     autoPathIndex = 0;
     currentTarget = TargetType::None;
+    // A decision of the last run may still be finishing on a worker; it keeps the old state
+    planner = std::make_shared<Planner>();
+    planRoute();
 }
 
 void DefaultAutoPlayStrategy::stop() {
+    if (planningService) {
+        planningService->cancel(PathPlanningService::AutoPlayChannel);
+        planningService->cancel(PathPlanningService::AutoPlayRouteChannel);
+    }
     autoPath.clear();
     autoPathIndex = 0;
     currentTarget = TargetType::None;
 }
 
+bool DefaultAutoPlayStrategy::isPlanning() const {
+    return planningService && planningService->isPending(PathPlanningService::AutoPlayChannel);
+}
+
 AutoPlayMove DefaultAutoPlayStrategy::nextStep() {
     if (!model) return {0,0};
 
@@ -30,6 +61,13 @@ AutoPlayMove DefaultAutoPlayStrategy::nextStep() {
     if (p->getHealth() <= 0 || p->getEnergy() <= 0) {
         return {0,0};
     }
+    if (isPlanning()) return {0,0};
+
+    if (autoPathIndex < (int)autoPath.size() && model->getBlockerEpoch() != seenBlockerEpoch) {
+        // An enemy teleported or was defeated since the path was planned
+        repairPath();
+        if (isPlanning()) return {0,0};
+    }
 
     if (autoPathIndex >= (int)autoPath.size()) {
         // No steps left
@@ -54,275 +92,442 @@ AutoPlayMove DefaultAutoPlayStrategy::nextStep() {
 
 void DefaultAutoPlayStrategy::decideNextAction() {
     if (!model) return;
-    auto *p = model->getProtagonist();
-    EnemyWrapper* targetEnemy = findNextTargetEnemy();
     autoPath.clear();
     autoPathIndex = 0;
+    request([](Planner &planner, SearchGrid &grid, const Situation &s) { return planner.decide(grid, s); });
+}
 
-    if (targetEnemy) {
-        float enemyDamage = targetEnemy->getStrength();
-        // Need health or not
-        if (p->getHealth() <= enemyDamage) {
-            // Need health pack first
-            if (!computePathToHealthPack()) {
-                // no HP found => just try enemy anyway
-                computePathToEnemy();
-                currentTarget = TargetType::Enemy;
-            } else {
-                currentTarget = TargetType::HealthPack;
-            }
-        } else if (p->getHealth() < 70.0f) {
-            // Try health pack first if possible
-            if (!computePathToHealthPack()) {
-                computePathToEnemy();
-                currentTarget = TargetType::Enemy;
-            } else {
-                currentTarget = TargetType::HealthPack;
-            }
-        } else {
-            // Just go to enemy
-            computePathToEnemy();
-            currentTarget = TargetType::Enemy;
-        }
-    } else {
-        // No enemy alive
-        // Only compute path to portal if no enemies
-        if (computePathToPortal()) {
-            currentTarget = TargetType::Portal;
-        } else {
-            currentTarget = TargetType::None;
-        }
+void DefaultAutoPlayStrategy::planPathToTile(int x, int y) {
+    if (!model) return;
+    autoPath.clear();
+    autoPathIndex = 0;
+    if (x<0||x>=model->getCols()||y<0||y>=model->getRows()) return;
+    int cell = model->getSearchGrid()->index(x, y);
+    request([cell](Planner &planner, SearchGrid &grid, const Situation &s) { return planner.toTile(grid, s, cell); });
+}
+
+void DefaultAutoPlayStrategy::planPathToEnemy() {
+    if (!model) return;
+    request([](Planner &planner, SearchGrid &grid, const Situation &s) { return planner.toEnemy(grid, s); });
+}
+
+void DefaultAutoPlayStrategy::planPathToHealthPack() {
+    if (!model) return;
+    request([](Planner &planner, SearchGrid &grid, const Situation &s) { return planner.toHealthPack(grid, s); });
+}
+
+void DefaultAutoPlayStrategy::planPathToPortal() {
+    if (!model) return;
+    request([](Planner &planner, SearchGrid &grid, const Situation &s) { return planner.toPortal(grid, s); });
+}
+
+DefaultAutoPlayStrategy::Situation DefaultAutoPlayStrategy::observe() const {
+    SearchGrid *grid = model->getSearchGrid();
+    auto *p = model->getProtagonist();
+    Situation s;
+    s.levelId = grid->getLevelId();
+    s.start = grid->index(p->getXPos(), p->getYPos());
+    s.health = p->getHealth();
+    s.energy = p->getEnergy();
+    for (auto &e : model->getEnemies()) {
+        s.enemies.push_back({grid->index(e->getXPos(), e->getYPos()), e->getStrength(), enemyDamage(e.get()), e->isDefeated()});
     }
+    for (auto &hp : model->getHealthPacks()) {
+        s.healthPacks.push_back({grid->index(hp->getXPos(), hp->getYPos()), hp->getHealAmount()});
+    }
+    for (auto &portal : model->getPortals()) {
+        s.portalCells.push_back(grid->index(portal->getXPos(), portal->getYPos()));
+    }
+    if (Portal *portal = model->getExitPortal(); portal && !s.portalCells.empty()) {
+        s.exitCell = grid->index(portal->getXPos(), portal->getYPos());
+    }
+    s.mask = model->getAutoPlayMask();
+    s.epsilon = model->getSearchPolicy(GameModel::QueryKind::AutoPlay).epsilon;
+    s.blockerEpoch = model->getBlockerEpoch();
+    s.route = route;
+    s.routeIndex = routeIndex;
+    return s;
 }
 
-bool DefaultAutoPlayStrategy::computePathToEnemy() {
-    EnemyWrapper* e = findNextTargetEnemy();
-    if (!e) {
-        autoPath.clear();
-        return false;
+bool DefaultAutoPlayStrategy::Situation::hasLivingEnemies() const {
+    for (const Enemy &e : enemies) {
+        if (!e.defeated) return true;
     }
+    return false;
+}
 
-    auto *p = model->getProtagonist();
-    resetNodes();
-    int cols = model->getCols();
-    Node &startNode = nodes[p->getYPos()*cols + p->getXPos()];
-    Node &endNode = nodes[e->getYPos()*cols + e->getXPos()];
-
-    // Avoid portal if enemies remain
-    bool enemiesAlive = (findNextTargetEnemy() != nullptr);
-
-    auto costFunc = [this, e, enemiesAlive](const Node &a, const Node &b) {
-        for (auto &enemy : model->getEnemies()) {
-            if (!enemy->isDefeated() && enemy.get() != e &&
-                enemy->getXPos()==b.getXPos() && enemy->getYPos()==b.getYPos()) {
-                return std::numeric_limits<float>::infinity();
-            }
+void DefaultAutoPlayStrategy::request(std::function<Decision(Planner &, SearchGrid &, const Situation &)> plan) {
+    Situation s = observe();
+    std::shared_ptr<Planner> state = planner;
+    auto job = [state, s, plan](SearchGrid &grid) {
+        std::lock_guard<std::mutex> guard(state->lock);
+        auto began = std::chrono::steady_clock::now();
+        Decision d = plan(*state, grid, s);
+        d.stats.epsilon = s.epsilon;
+        d.stats.expanded = state->takeExpanded();
+        int current = s.start;
+        for (int dir : d.path) {
+            current = grid.index(grid.xOf(current) + SearchGrid::dirDx[dir], grid.yOf(current) + SearchGrid::dirDy[dir]);
+            d.stats.cost += grid.getStepCost(current);
         }
-        // Avoid portal if enemies still alive
-        if (enemiesAlive) {
-            for (auto &port : model->getPortals()) {
-                if (port->getXPos()==b.getXPos() && port->getYPos()==b.getYPos()) {
-                    return std::numeric_limits<float>::infinity();
-                }
-            }
-        }
-
-        return defaultCostFunc(b);
+        d.stats.steps = d.path.size();
+        d.stats.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - began).count();
+        return d;
     };
 
-    auto heuristicFunc = defaultHeuristicFunc;
+    if (!planningService) {
+        apply(s, job(*model->getSearchGrid()));
+        return;
+    }
+    // The protagonist waits (isPlanning) until the decision arrives
+    planningService->submit<Decision>(PathPlanningService::AutoPlayChannel, model->getSharedSearchGrid(), job,
+        [this, s](Decision d) { apply(s, std::move(d)); });
+}
 
-    autoPath = findPath(startNode.getXPos(), startNode.getYPos(),
-                        endNode.getXPos(), endNode.getYPos(),
-                        costFunc, heuristicFunc);
+void DefaultAutoPlayStrategy::apply(const Situation &s, Decision d) {
+    lastQuery = d.stats;
+    SearchGrid *grid = model->getSearchGrid();
+    auto *p = model->getProtagonist();
+    // Planned for a position or level we have left: drop the old path too, the next step decides again
+    if (!grid || grid->getLevelId() != s.levelId || grid->index(p->getXPos(), p->getYPos()) != s.start) {
+        autoPath.clear();
+        autoPathIndex = 0;
+        return;
+    }
 
+    autoPath = std::move(d.path);
     autoPathIndex = 0;
-    return !autoPath.empty();
+    targetCell = d.targetCell;
+    currentTarget = d.target;
+    // Blocker changes made while the worker searched get repaired on the next step
+    seenBlockerEpoch = s.blockerEpoch;
+    // A route that arrived meanwhile starts from its own first stop
+    if (s.route == route) routeIndex = d.routeIndex;
 }
 
-bool DefaultAutoPlayStrategy::computePathToHealthPack() {
-    resetNodes();
+void DefaultAutoPlayStrategy::planRoute() {
+    routeIndex = 0;
+    SearchGrid *grid = model->getSearchGrid();
     auto *p = model->getProtagonist();
-    HealthPack *nearestHP = nullptr;
-    float minDist = std::numeric_limits<float>::max();
-    for (auto &hp : model->getHealthPacks()) {
-        float dist = std::sqrt((hp->getXPos()-p->getXPos())*(hp->getXPos()-p->getXPos())
-                               + (hp->getYPos()-p->getYPos())*(hp->getYPos()-p->getYPos()));
-        if (dist < minDist) {
-            minDist = dist;
-            nearestHP = hp.get();
-        }
+    if (!grid || !p) return;
+
+    std::vector<RoutePlanner::Stop> enemyStops;
+    const auto &enemies = model->getEnemies();
+    for (size_t i = 0; i < enemies.size(); ++i) {
+        EnemyWrapper *e = enemies[i].get();
+        if (e->isDefeated()) continue;
+        enemyStops.push_back({RoutePlanner::Stop::Kind::Enemy, grid->index(e->getXPos(), e->getYPos()),
+                              static_cast<int>(i), enemyDamage(e)});
     }
 
-    if (!nearestHP) {
-        autoPath.clear();
-        return false;
+    std::vector<RoutePlanner::Stop> packStops;
+    const auto &packs = model->getHealthPacks();
+    for (size_t i = 0; i < packs.size(); ++i) {
+        packStops.push_back({RoutePlanner::Stop::Kind::HealthPack, grid->index(packs[i]->getXPos(), packs[i]->getYPos()),
+                             static_cast<int>(i), packs[i]->getHealAmount()});
     }
 
-    bool enemiesAlive = (findNextTargetEnemy() != nullptr);
-
-    int cols = model->getCols();
-    Node &startNode = nodes[p->getYPos()*cols + p->getXPos()];
-    Node &endNode = nodes[nearestHP->getYPos()*cols + nearestHP->getXPos()];
+    int portalCell = -1;
+    if (Portal *portal = model->getExitPortal()) {
+        portalCell = grid->index(portal->getXPos(), portal->getYPos());
+    }
 
-    auto costFunc = [this, enemiesAlive](const Node &a, const Node &b) {
-        for (auto &e : model->getEnemies()) {
-            if(!e->isDefeated() && e->getXPos()==b.getXPos() && e->getYPos()==b.getYPos()) {
-                return std::numeric_limits<float>::infinity();
-            }
-        }
-        if (enemiesAlive) {
-            for (auto &port : model->getPortals()) {
-                if (port->getXPos()==b.getXPos() && port->getYPos()==b.getYPos()) {
-                    return std::numeric_limits<float>::infinity();
-                }
-            }
-        }
-        return defaultCostFunc(b);
+    int start = grid->index(p->getXPos(), p->getYPos());
+    float health = p->getHealth();
+    uint8_t mask = model->getAutoPlayMask();
+    // POI pairs the background matrix already measured are looked up instead of flooded
+    std::shared_ptr<const PoiDistanceMatrix> known = model->getPoiDistances();
+    auto planOn = [start, health, enemyStops, packStops, portalCell, mask, known](SearchGrid &g) {
+        RoutePlanner planner;
+        planner.plan(g, start, health, enemyStops, packStops, portalCell, mask, known.get());
+        return std::make_shared<const Route>(planner.getRoute());
     };
-    auto heuristicFunc = defaultHeuristicFunc;
 
-    autoPath = findPath(startNode.getXPos(), startNode.getYPos(),
-                        endNode.getXPos(), endNode.getYPos(),
-                        costFunc, heuristicFunc);
-    autoPathIndex = 0;
-    return !autoPath.empty();
+    route.reset();
+    if (!planningService) {
+        route = planOn(*grid);
+        return;
+    }
+    // Stops already dealt with by the time the route arrives are skipped by followRoute()
+    planningService->submit<std::shared_ptr<const Route>>(PathPlanningService::AutoPlayRouteChannel,
+        model->getSharedSearchGrid(), planOn,
+        [this](std::shared_ptr<const Route> planned) {
+            route = std::move(planned);
+            routeIndex = 0;
+        });
 }
 
-bool DefaultAutoPlayStrategy::computePathToPortal() {
-    resetNodes();
-    // If no portals or enemies alive (this method only called if no enemies), just go portal
-    if (model->getPortals().empty()) {
+float DefaultAutoPlayStrategy::enemyDamage(const EnemyWrapper *e) const {
+    float damage = e->getStrength();
+    if (dynamic_cast<PEnemy*>(e->getRaw())) damage += kPoisonDamage;
+    return damage;
+}
+
+void DefaultAutoPlayStrategy::repairPath() {
+    SearchGrid *grid = model->getSearchGrid();
+    std::vector<int> changes;
+    bool known = model->getBlockerChangesSince(seenBlockerEpoch, changes);
+    seenBlockerEpoch = model->getBlockerEpoch();
+
+    // The enemy we were heading for teleported away or died: let decideNextAction pick again
+    if (currentTarget == TargetType::Enemy && !grid->isBlocked(targetCell, SearchGrid::BlockEnemy)) {
         autoPath.clear();
-        return false;
+        autoPathIndex = 0;
+        return;
     }
 
-    auto *p = model->getProtagonist();
-    Portal *portal = model->getPortals().front().get();
-    int cols = model->getCols();
-    Node &startNode = nodes[p->getYPos()*cols + p->getXPos()];
-    Node &endNode = nodes[portal->getYPos()*cols + portal->getXPos()];
-
-    // If decideNextAction calls computePathToPortal, it means no enemies alive, so no need to avoid portal
-    bool enemiesAlive = (findNextTargetEnemy() != nullptr);
-
-    auto costFunc = [this, enemiesAlive](const Node &a, const Node &b) {
-        for (auto &e : model->getEnemies()) {
-            if (!e->isDefeated() && e->getXPos()==b.getXPos() && e->getYPos()==b.getYPos()) {
-                return std::numeric_limits<float>::infinity();
+    // First change on this route plans once; later ones only repair the cells around the change
+    int cell = targetCell;
+    TargetType target = currentTarget;
+    request([cell, target, known, changes](Planner &planner, SearchGrid &grid, const Situation &s) {
+        Decision d = planner.repair(grid, s, cell, known ? &changes : nullptr);
+        d.target = target;
+        return d;
+    });
+}
+
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::decide(SearchGrid &grid, const Situation &s) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    replanner.reset();
+
+    // The route names the next stop, so one (adaptive) search to it is enough; the greedy
+    // rules compare several targets and need the flood
+    if (followRoute(grid, s, d)) return d;
+    refreshDistances(grid, s);
+    decideGreedyAction(grid, s, d);
+    return d;
+}
+
+bool DefaultAutoPlayStrategy::Planner::followRoute(SearchGrid &grid, const Situation &s, Decision &d) {
+    if (!s.route) return false;
+    const auto &stops = *s.route;
+
+    while (d.routeIndex < stops.size()) {
+        const RoutePlanner::Stop &stop = stops[d.routeIndex];
+        int cell = stop.cell;
+        float damage = 0.0f;
+
+        if (stop.kind == RoutePlanner::Stop::Kind::Enemy) {
+            if (stop.id >= (int)s.enemies.size()) { ++d.routeIndex; continue; }
+            const Situation::Enemy &e = s.enemies[stop.id];
+            if (e.defeated) { ++d.routeIndex; continue; }
+            // Off plan (poison, an XEnemy's second fight): the greedy rules fetch health first
+            if (s.health <= e.damage) return false;
+            cell = e.cell; // XEnemies teleport
+            damage = e.damage;
+            d.target = TargetType::Enemy;
+        } else if (stop.kind == RoutePlanner::Stop::Kind::HealthPack) {
+            bool present = false;
+            for (const auto &hp : s.healthPacks) {
+                if (hp.cell == cell) present = true;
             }
+            if (!present) { ++d.routeIndex; continue; }
+            d.target = TargetType::HealthPack;
+        } else {
+            if (s.hasLivingEnemies()) return false;
+            d.target = TargetType::Portal;
         }
-        // If by any chance enemiesAlive is true here, avoid portal:
-        if (enemiesAlive) {
-            for (auto &port : model->getPortals()) {
-                if (port->getXPos()==b.getXPos() && port->getYPos()==b.getYPos()) {
-                    return std::numeric_limits<float>::infinity();
-                }
+
+        d.path = searchTo(grid, s, cell);
+        if (d.path.empty()) { ++d.routeIndex; continue; }
+
+        // Energy never comes back: a leg it can't pay for is exchanged for the cheapest
+        // affordable one, or the stop is given up
+        if (pathCost(grid, s.start, d.path) > s.energy) {
+            ResourceSearch::Result affordable = affordablePathTo(grid, s, cell, damage);
+            if (affordable.status != ResourceSearch::Status::Found) {
+                d.path.clear();
+                ++d.routeIndex;
+                continue;
             }
+            d.path = std::move(affordable.path);
         }
+        d.targetCell = cell;
+        return true;
+    }
+    d.target = TargetType::None;
+    return false;
+}
 
-        return defaultCostFunc(b);
-    };
-    auto heuristicFunc = defaultHeuristicFunc;
+void DefaultAutoPlayStrategy::Planner::decideGreedyAction(SearchGrid &grid, const Situation &s, Decision &d) {
+    int target = nearestEnemy(s);
 
-    autoPath = findPath(startNode.getXPos(), startNode.getYPos(),
-                        endNode.getXPos(), endNode.getYPos(),
-                        costFunc, heuristicFunc);
-    autoPathIndex = 0;
-    return !autoPath.empty();
+    if (target >= 0) {
+        const Situation::Enemy &enemy = s.enemies[target];
+        // Need health or not
+        if (s.health <= enemy.strength) {
+            // Cheapest pack that still leaves the energy to reach the enemy afterwards
+            ResourceSearch::Result affordable = affordablePathTo(grid, s, enemy.cell, enemy.damage);
+            if (affordable.status == ResourceSearch::Status::Found && affordable.healthPack >= 0) {
+                // Walk to the pack only; the next decision starts from the new health
+                int x = grid.xOf(s.start);
+                int y = grid.yOf(s.start);
+                d.path.clear();
+                for (int dir : affordable.path) {
+                    d.path.push_back(dir);
+                    x += SearchGrid::dirDx[dir];
+                    y += SearchGrid::dirDy[dir];
+                    if (grid.index(x, y) == affordable.healthPack) break;
+                }
+                d.targetCell = affordable.healthPack;
+                d.target = TargetType::HealthPack;
+            } else if (!pathToHealthPack(s, d)) {
+                // no HP found => just try enemy anyway
+                pathToEnemy(s, d);
+            }
+        } else if (s.health < 70.0f) {
+            // Try health pack first if possible
+            if (!pathToHealthPack(s, d)) pathToEnemy(s, d);
+        } else {
+            // Just go to enemy
+            pathToEnemy(s, d);
+        }
+    } else {
+        // No enemy alive
+        // Only compute path to portal if no enemies
+        if (!pathToPortal(s, d)) d.target = TargetType::None;
+    }
 }
 
-bool DefaultAutoPlayStrategy::computePathToTile(int x, int y) {
-    resetNodes();
-    auto *p = model->getProtagonist();
-    if (x<0||x>=model->getCols()||y<0||y>=model->getRows()) {
-        autoPath.clear();
-        return false;
-    }
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::toEnemy(SearchGrid &grid, const Situation &s) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    refreshDistances(grid, s);
+    pathToEnemy(s, d);
+    return d;
+}
 
-    bool enemiesAlive = (findNextTargetEnemy() != nullptr);
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::toHealthPack(SearchGrid &grid, const Situation &s) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    refreshDistances(grid, s);
+    pathToHealthPack(s, d);
+    return d;
+}
 
-    int cols = model->getCols();
-    Node &startNode = nodes[p->getYPos()*cols + p->getXPos()];
-    Node &endNode = nodes[y*cols + x];
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::toPortal(SearchGrid &grid, const Situation &s) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    refreshDistances(grid, s);
+    pathToPortal(s, d);
+    return d;
+}
 
-    auto costFunc = [this, enemiesAlive](const Node &a, const Node &b) {
-        for (auto &e : model->getEnemies()) {
-            if (!e->isDefeated() && e->getXPos()==b.getXPos() && e->getYPos()==b.getYPos()) {
-                return std::numeric_limits<float>::infinity();
-            }
-        }
-        // Avoid portal if enemies alive
-        if (enemiesAlive) {
-            for (auto &port : model->getPortals()) {
-                if (port->getXPos()==b.getXPos() && port->getYPos()==b.getYPos()) {
-                    return std::numeric_limits<float>::infinity();
-                }
-            }
-        }
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::toTile(SearchGrid &grid, const Situation &s, int cell) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    replanner.reset();
+    // Avoids other enemies, and the portal while enemies remain
+    SearchPolicy policy{s.epsilon, false};
+    d.path = grid.findPath(s.start, cell, s.mask, policy.modeFor(SearchMode::JumpPoint), policy.epsilon);
+    expanded += grid.getLastQuery().expanded;
+    d.targetCell = cell;
+    return d;
+}
 
-        return defaultCostFunc(b);
-    };
-    auto heuristicFunc = defaultHeuristicFunc;
+DefaultAutoPlayStrategy::Decision DefaultAutoPlayStrategy::Planner::repair(SearchGrid &grid, const Situation &s,
+                                                                           int targetCell, const std::vector<int> *changes) {
+    Decision d;
+    d.routeIndex = s.routeIndex;
+    d.targetCell = targetCell;
+    d.path = replanner.replan(grid, s.start, targetCell, s.mask, changes);
+    expanded += replanner.getExpanded();
+    return d;
+}
 
-    autoPath = findPath(startNode.getXPos(), startNode.getYPos(),
-                        endNode.getXPos(), endNode.getYPos(),
-                        costFunc, heuristicFunc);
-    autoPathIndex = 0;
-    return !autoPath.empty();
+bool DefaultAutoPlayStrategy::Planner::pathToEnemy(const Situation &s, Decision &d) {
+    int target = nearestEnemy(s);
+    if (target < 0) {
+        d.path.clear();
+        return false;
+    }
+
+    d.targetCell = s.enemies[target].cell;
+    d.target = TargetType::Enemy;
+    d.path = distances.pathTo(d.targetCell);
+    return !d.path.empty();
 }
 
-EnemyWrapper* DefaultAutoPlayStrategy::findNextTargetEnemy() {
-    EnemyWrapper *targetEnemy = nullptr;
-    float minDistance = std::numeric_limits<float>::max();
-    auto *p = model->getProtagonist();
+bool DefaultAutoPlayStrategy::Planner::pathToHealthPack(const Situation &s, Decision &d) {
+    std::vector<int> cells;
+    for (const auto &hp : s.healthPacks) cells.push_back(hp.cell);
 
-    for (auto &e : model->getEnemies()) {
-        if (!e->isDefeated()) {
-            float dist = std::sqrt((e->getXPos() - p->getXPos())*(e->getXPos()-p->getXPos())
-                                   + (e->getYPos() - p->getYPos())*(e->getYPos()-p->getYPos()));
-            if (dist < minDistance) {
-                minDistance = dist;
-                targetEnemy = e.get();
-            }
-        }
+    int nearest = distances.nearest(cells);
+    if (nearest < 0) {
+        d.path.clear();
+        return false;
     }
 
-    return targetEnemy;
+    d.targetCell = cells[nearest];
+    d.target = TargetType::HealthPack;
+    d.path = distances.pathTo(d.targetCell);
+    return !d.path.empty();
 }
 
-void DefaultAutoPlayStrategy::resetNodes() {
-    nodes.clear();
-    const auto &tiles = model->getTiles();
-    nodes.reserve(tiles.size());
+bool DefaultAutoPlayStrategy::Planner::pathToPortal(const Situation &s, Decision &d) {
+    // If no portals or enemies alive (this method only called if no enemies), just go portal
+    if (s.exitCell < 0) {
+        d.path.clear();
+        return false;
+    }
+
+    d.targetCell = s.exitCell;
+    d.target = TargetType::Portal;
+    d.path = distances.pathTo(d.targetCell);
+    return !d.path.empty();
+}
 
-    for (auto &tw : tiles) {
-        Node n(tw->getXPos(), tw->getYPos(), tw->getValue());
-        n.f = n.g = n.h = 0;
-        n.visited = n.closed = false;
-        n.prev = nullptr;
-        nodes.push_back(n);
+void DefaultAutoPlayStrategy::Planner::refreshDistances(SearchGrid &grid, const Situation &s) {
+    // One flood answers every "nearest" question of this decision
+    std::vector<int> targets;
+    for (const auto &e : s.enemies) {
+        if (!e.defeated) targets.push_back(e.cell);
     }
+    for (const auto &hp : s.healthPacks) targets.push_back(hp.cell);
+    targets.insert(targets.end(), s.portalCells.begin(), s.portalCells.end());
+
+    distances.compute(grid, s.start, targets, s.mask);
+    expanded += distances.getExpanded();
+    replanner.reset();
 }
 
-std::vector<int> DefaultAutoPlayStrategy::findPath(
-    int startX, int startY, int endX, int endY,
-    std::function<float(const Node&,const Node&)> costFunc,
-    std::function<float(const Node&,const Node&)> heuristicFunc)
-{
-    int cols = model->getCols();
-    Node &startNode = nodes[startY*cols + startX];
-    Node &endNode = nodes[endY*cols + endX];
+int DefaultAutoPlayStrategy::Planner::nearestEnemy(const Situation &s) const {
+    std::vector<int> candidates;
+    std::vector<int> cells;
+    for (size_t i = 0; i < s.enemies.size(); ++i) {
+        if (!s.enemies[i].defeated) {
+            candidates.push_back(static_cast<int>(i));
+            cells.push_back(s.enemies[i].cell);
+        }
+    }
 
-    PathFinder<Node, Node> pathfinder(nodes, &startNode, &endNode, nodeComparator,(unsigned int)cols,costFunc,heuristicFunc,1.0f);
-    return pathfinder.A_star();
+    // Closest by walking distance; enemies behind walls are never picked
+    int nearest = distances.nearest(cells);
+    return nearest < 0 ? -1 : candidates[nearest];
 }
 
-float DefaultAutoPlayStrategy::defaultCostFunc(const Node &b) {
-    return 1.0f/(b.getValue()+1.0f)*0.1f;
+std::vector<int> DefaultAutoPlayStrategy::Planner::searchTo(SearchGrid &grid, const Situation &s, int cell) {
+    if (!grid.canReach(s.start, cell, s.mask)) return {};
+
+    // Picks up what the previous searches on this level learned, unless blockers changed since
+    std::vector<int> path = adaptiveSearch.findPath(grid, s.start, cell, s.mask, s.epsilon);
+    expanded += adaptiveSearch.getExpanded();
+    return path;
 }
 
-float DefaultAutoPlayStrategy::defaultHeuristicFunc(const Node &a, const Node &b) {
-    return std::sqrt((a.getXPos()-b.getXPos())*(a.getXPos()-b.getXPos())
-                     + (a.getYPos()-b.getYPos())*(a.getYPos()-b.getYPos()));
+ResourceSearch::Result DefaultAutoPlayStrategy::Planner::affordablePathTo(SearchGrid &grid, const Situation &s,
+                                                                         int cell, float goalDamage) {
+    ResourceSearch::Request request;
+    request.start = s.start;
+    request.goal = cell;
+    // Same blockers as the leg it replaces (searchTo)
+    request.blockerMask = s.mask;
+    request.energy = s.energy;
+    request.health = s.health;
+    request.goalDamage = goalDamage;
+    request.healthPacks = s.healthPacks;
+    ResourceSearch::Result result = resourceSearch.findPath(grid, request);
+    expanded += result.labels; // its unit of work: one label per (cell, resources) state
+    return result;
 }
@@ -2,71 +2,161 @@
 #define DEFAULTAUTOPLAYSTRATEGY_H
 
 #include "autoplaystrategy.h"
-#include "node.h"
-#include "pathfinder_class.h"
+#include "searchgrid.h"
+#include "distancemap.h"
+#include "dstarlite.h"
+#include "routeplanner.h"
+#include "adaptivesearch.h"
+#include "resourcesearch.h"
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 class EnemyWrapper;
 class GameModel;
+class PathPlanningService;
 
 class DefaultAutoPlayStrategy : public AutoPlayStrategy {
 public:
-    DefaultAutoPlayStrategy(std::function<bool(const Node&,const Node&)> nodeComparator)
-        : model(nullptr), autoPathIndex(0), nodeComparator(nodeComparator)
+    DefaultAutoPlayStrategy()
+        : model(nullptr), autoPathIndex(0), planner(std::make_shared<Planner>()), planningService(nullptr)
     {}
 
+    // When set, decisions and the whole-level route are planned off the GUI thread; until the
+    // route arrives decisions use the greedy rules.
+    void setPlanningService(PathPlanningService *service) { planningService = service; }
+
     void start(GameModel *model) override;
     void stop() override;
     AutoPlayMove nextStep() override;
+    bool isPlanning() const override;
+    SearchGrid::QueryStats getLastQuery() const override { return lastQuery; }
 
     void decideNextAction() override;
 
-    void planPathToTile(int x, int y) override {
-        computePathToTile(x,y);
-    }
-
-    void planPathToEnemy() override {
-        computePathToEnemy();
-    }
-
-    void planPathToHealthPack() override {
-        computePathToHealthPack();
-    }
-
-    void planPathToPortal() override {
-        computePathToPortal();
-    }
+    void planPathToTile(int x, int y) override;
+    void planPathToEnemy() override;
+    void planPathToHealthPack() override;
+    void planPathToPortal() override;
 
     void planPathToEnemyWithHealthPacks() override {
         decideNextAction();
     }
 
 private:
+    enum class TargetType { None, Enemy, HealthPack, Portal };
+    using Route = std::vector<RoutePlanner::Stop>;
+
+    // The level as one decision sees it, copied on the GUI thread so the decision can run on a worker
+    struct Situation {
+        struct Enemy {
+            int cell;
+            float strength;
+            float damage; // strength plus poison, see enemyDamage()
+            bool defeated;
+        };
+
+        uint64_t levelId = 0;
+        int start = -1;
+        float health = 0.0f;
+        float energy = 0.0f;
+        std::vector<Enemy> enemies; // indexed like GameModel::getEnemies()
+        std::vector<ResourceSearch::HealthPackSite> healthPacks;
+        std::vector<int> portalCells;
+        int exitCell = -1;
+        uint8_t mask = 0;           // getAutoPlayMask()
+        float epsilon = 1.0f;
+        uint64_t blockerEpoch = 0;
+        std::shared_ptr<const Route> route;
+        size_t routeIndex = 0;
+
+        bool hasLivingEnemies() const;
+    };
+
+    // What a decision hands back to the GUI thread
+    struct Decision {
+        std::vector<int> path;
+        int targetCell = -1;
+        TargetType target = TargetType::None;
+        size_t routeIndex = 0;
+        SearchGrid::QueryStats stats; // whole decision: every search and flood it ran
+    };
+
+    /**
+     * @brief Search state carried between the decisions of one autoplay run: the adaptive
+     * heuristic, the distance flood and the D* Lite tree. A decision holds the lock while it
+     * runs, so a superseded one still finishing on a worker never overlaps the next.
+     */
+    class Planner {
+    public:
+        std::mutex lock;
+
+        // Next route stop if the route still applies, otherwise the greedy rules
+        Decision decide(SearchGrid &grid, const Situation &s);
+        Decision toEnemy(SearchGrid &grid, const Situation &s);
+        Decision toHealthPack(SearchGrid &grid, const Situation &s);
+        Decision toPortal(SearchGrid &grid, const Situation &s);
+        Decision toTile(SearchGrid &grid, const Situation &s, int cell);
+        // Repairs the path to targetCell after the blocker changes listed in changes (nullptr if unknown)
+        Decision repair(SearchGrid &grid, const Situation &s, int targetCell, const std::vector<int> *changes);
+        // Cells expanded by every engine since the last call
+        uint64_t takeExpanded() noexcept { return std::exchange(expanded, 0); }
+
+    private:
+        bool followRoute(SearchGrid &grid, const Situation &s, Decision &d);
+        // Nearest-enemy rules with a health-pack detour; used once the route is done or off plan
+        void decideGreedyAction(SearchGrid &grid, const Situation &s, Decision &d);
+
+        // Path distances from the protagonist to every enemy, health pack and portal
+        void refreshDistances(SearchGrid &grid, const Situation &s);
+        int nearestEnemy(const Situation &s) const;
+        bool pathToEnemy(const Situation &s, Decision &d);
+        bool pathToHealthPack(const Situation &s, Decision &d);
+        bool pathToPortal(const Situation &s, Decision &d);
+
+        // Route legs: Adaptive A* whose learned heuristic carries over between the searches of a level
+        std::vector<int> searchTo(SearchGrid &grid, const Situation &s, int cell);
+
+        // Cheapest route to cell the protagonist's energy and health can pay for, arriving with
+        // more than goalDamage health; may pass a health pack on the way
+        ResourceSearch::Result affordablePathTo(SearchGrid &grid, const Situation &s, int cell, float goalDamage);
+
+        AdaptiveSearch adaptiveSearch;
+        ResourceSearch resourceSearch;
+        DistanceMap distances;
+        DStarLite replanner;
+        uint64_t expanded = 0;
+    };
+
     GameModel *model;
     std::vector<int> autoPath;
     int autoPathIndex;
-    std::function<bool(const Node&, const Node&)> nodeComparator;
-
-    enum class TargetType { None, Enemy, HealthPack, Portal };
     TargetType currentTarget = TargetType::None;
 
-    std::vector<Node> nodes;
-
-    EnemyWrapper* findNextTargetEnemy();
-    void resetNodes();
-
-    bool computePathToEnemy();
-    bool computePathToHealthPack();
-    bool computePathToPortal();
-    bool computePathToTile(int x, int y);
-
-    std::vector<int> findPath(int startX, int startY, int endX, int endY,
-                              std::function<float(const Node&,const Node&)> costFunc,
-                              std::function<float(const Node&,const Node&)> heuristicFunc);
-
-    float defaultCostFunc(const Node &b);
-    static float defaultHeuristicFunc(const Node &a, const Node &b);
+    // Cell autoPath leads to, and the blocker epoch it was planned against
+    int targetCell = -1;
+    uint64_t seenBlockerEpoch = 0;
+    void repairPath();
+    SearchGrid::QueryStats lastQuery;
+
+    std::shared_ptr<Planner> planner;
+    PathPlanningService *planningService;
+
+    // Whole-level visiting order, planned each time autoplay starts
+    std::shared_ptr<const Route> route;
+    size_t routeIndex = 0;
+    void planRoute();
+    float enemyDamage(const EnemyWrapper *e) const;
+
+    Situation observe() const;
+    // Runs plan on a worker (or right here without a planning service) and applies its decision,
+    // unless the protagonist or the level moved on in the meantime
+    void request(std::function<Decision(Planner &, SearchGrid &, const Situation &)> plan);
+    void apply(const Situation &s, Decision d);
 };
 
 #endif // DEFAULTAUTOPLAYSTRATEGY_H
@@ -0,0 +1,113 @@
+#include "distancemap.h"
+#include <algorithm>
+#include <limits>
+
+void DistanceMap::compute(const SearchGrid &g, int src, const std::vector<int> &targets, uint8_t blockerMask)
+{
+    std::vector<int> sorted = targets;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    // Versions are unique across levels and shared by worker copies of a grid, so the flood
+    // can be reused from whichever copy computed it
+    grid = &g;
+    expanded = 0;
+    if (source == src && mask == blockerMask && blockerVersion == g.getBlockerVersion() && sorted == targetCells) {
+        return;
+    }
+
+    source = src;
+    mask = blockerMask;
+    blockerVersion = g.getBlockerVersion();
+    targetCells = std::move(sorted);
+
+    workspace.setOpenListKind(g.getOpenListKind());
+    workspace.begin(g.size());
+    if (src < 0 || src >= g.size()) return;
+
+    workspace.reach(src, 0.0f, src);
+    workspace.f[src] = 0.0f;
+    workspace.push(0.0f, src);
+    size_t remaining = targetCells.size();
+
+    while (!workspace.openEmpty() && remaining > 0 && !g.isCancelled()) {
+        SearchWorkspace::OpenEntry current = workspace.pop();
+        if (current.f > workspace.g[current.index]) continue;
+        ++expanded;
+
+        if (isTarget(current.index)) {
+            --remaining;
+            // Reached an enemy (or a portal we avoid): its cell ends the route, never passes it on
+            if (current.index != src && g.isBlocked(current.index, blockerMask)) continue;
+        }
+
+        int cx = g.xOf(current.index);
+        int cy = g.yOf(current.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!g.inBounds(nx, ny)) continue;
+
+            int next = g.index(nx, ny);
+            float step = g.getStepCost(next, blockerMask);
+            if (step == std::numeric_limits<float>::infinity()) {
+                if (!g.isPassable(next) || !isTarget(next)) continue;
+                step = g.getStepCost(next);
+            }
+
+            float newG = workspace.g[current.index] + step;
+            if (workspace.isReached(next) && newG >= workspace.g[next]) continue;
+
+            workspace.reach(next, newG, current.index);
+            workspace.f[next] = newG;
+            workspace.push(newG, next);
+        }
+    }
+
+    // A cancelled flood is incomplete; never hand it out as the answer to a repeated query
+    if (g.isCancelled()) grid = nullptr;
+}
+
+bool DistanceMap::isTarget(int cell) const
+{
+    return std::binary_search(targetCells.begin(), targetCells.end(), cell);
+}
+
+bool DistanceMap::isReachable(int cell) const noexcept
+{
+    return grid && cell >= 0 && cell < grid->size() && workspace.isReached(cell);
+}
+
+float DistanceMap::distanceTo(int cell) const noexcept
+{
+    return isReachable(cell) ? workspace.g[cell] : std::numeric_limits<float>::infinity();
+}
+
+int DistanceMap::nearest(const std::vector<int> &cells) const
+{
+    int best = -1;
+    float bestDist = std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < cells.size(); ++i) {
+        float dist = distanceTo(cells[i]);
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+std::vector<int> DistanceMap::pathTo(int cell) const
+{
+    std::vector<int> path;
+    if (!isReachable(cell)) return path;
+
+    int current = cell;
+    while (current != source) {
+        int prev = static_cast<int>(workspace.parent[current]);
+        path.push_back(SearchGrid::directionBetween(grid->xOf(prev), grid->yOf(prev),
+                                                    grid->xOf(current), grid->yOf(current)));
+        current = prev;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,53 @@
+#ifndef DISTANCEMAP_H
+#define DISTANCEMAP_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief True path distances from one source cell to a set of targets, from a single Dijkstra flood.
+ *
+ * Used for "nearest reachable" decisions: one flood from the protagonist settles every
+ * enemy, health pack and portal at once, so choosing a target is a lookup and its path
+ * is read straight off the parent chain. Targets behind walls simply stay unreachable.
+ * The workspace is kept between floods, so repeated decisions on a level allocate nothing.
+ */
+class DistanceMap {
+public:
+    /**
+     * @brief Floods from source until every target is settled or the region is exhausted.
+     * Target cells may be entered even when blocked (an enemy stands on its own cell),
+     * but the flood never continues through them. Repeating the last query against an
+     * unchanged blocker version keeps the previous result.
+     */
+    void compute(const SearchGrid &grid, int source, const std::vector<int> &targets, uint8_t blockerMask);
+
+    // Exact for targets; other cells may only hold a tentative distance after an early stop.
+    bool isReachable(int cell) const noexcept;
+    float distanceTo(int cell) const noexcept;
+
+    // Index into cells of the closest reachable one, or -1 if none can be reached.
+    int nearest(const std::vector<int> &cells) const;
+
+    // 0-7 directions from the source to cell; empty if unreachable.
+    std::vector<int> pathTo(int cell) const;
+
+    int getSource() const noexcept { return source; }
+    // Cells settled by the last compute(); 0 when it kept the previous flood
+    uint64_t getExpanded() const noexcept { return expanded; }
+
+private:
+    bool isTarget(int cell) const;
+
+    const SearchGrid *grid = nullptr;
+    int source = -1;
+    uint8_t mask = 0;
+    uint64_t blockerVersion = 0;
+    uint64_t expanded = 0;
+    SearchWorkspace workspace;
+    std::vector<int> targetCells; // sorted, unique
+};
+
+#endif // DISTANCEMAP_H
@@ -0,0 +1,215 @@
+#include "dstarlite.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+namespace {
+constexpr float kInf = std::numeric_limits<float>::infinity();
+}
+
+std::vector<int> DStarLite::replan(const SearchGrid &g, int startCell, int goalCell, uint8_t mask,
+                                   const std::vector<int> *changedCells)
+{
+    if (startCell < 0 || startCell >= g.size() || goalCell < 0 || goalCell >= g.size() || startCell == goalCell) {
+        planned = false;
+        return {};
+    }
+
+    // The tree survives a switch to another worker copy of the same level
+    grid = &g;
+    expanded = 0;
+    if (!planned || levelId != g.getLevelId() || goal != goalCell || blockerMask != mask || !changedCells) {
+        levelId = g.getLevelId();
+        blockerMask = mask;
+        begin(startCell, goalCell);
+    } else {
+        start = startCell;
+        if (!changedCells->empty()) {
+            // Keys already queued were computed from lastStart; shifting km keeps them comparable
+            km += heuristic(lastStart, start);
+            lastStart = start;
+            for (int cell : *changedCells) {
+                if (cell >= 0 && cell < grid->size()) updateNeighbours(cell);
+            }
+        }
+    }
+
+    computeShortestPath();
+    planned = true;
+    return extractPath();
+}
+
+void DStarLite::begin(int startCell, int goalCell)
+{
+    int cellCount = grid->size();
+    if (stamp.size() != static_cast<size_t>(cellCount)) {
+        gValues.resize(cellCount);
+        rhsValues.resize(cellCount);
+        stamp.assign(cellCount, 0);
+        generation = 0;
+    }
+    ++generation;
+    if (generation == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    open.clear();
+
+    start = startCell;
+    lastStart = startCell;
+    goal = goalCell;
+    km = 0.0f;
+
+    touch(goal);
+    rhsValues[goal] = 0.0f;
+    open.push_back({calculateKey(goal), goal});
+}
+
+float DStarLite::g(int idx) const noexcept
+{
+    return stamp[idx] == generation ? gValues[idx] : kInf;
+}
+
+float DStarLite::rhs(int idx) const noexcept
+{
+    return stamp[idx] == generation ? rhsValues[idx] : kInf;
+}
+
+void DStarLite::touch(int idx)
+{
+    if (stamp[idx] != generation) {
+        stamp[idx] = generation;
+        gValues[idx] = kInf;
+        rhsValues[idx] = kInf;
+    }
+}
+
+float DStarLite::enterCost(int idx) const noexcept
+{
+    return idx == goal ? grid->getStepCost(idx) : grid->getStepCost(idx, blockerMask);
+}
+
+float DStarLite::heuristic(int a, int b) const noexcept
+{
+    int dx = std::abs(grid->xOf(a) - grid->xOf(b));
+    int dy = std::abs(grid->yOf(a) - grid->yOf(b));
+    return grid->getMinStepCost() * static_cast<float>(std::max(dx, dy));
+}
+
+DStarLite::Key DStarLite::calculateKey(int idx) const noexcept
+{
+    float best = std::min(g(idx), rhs(idx));
+    return {best + heuristic(start, idx) + km, best};
+}
+
+void DStarLite::updateVertex(int idx)
+{
+    touch(idx);
+    if (idx != goal) {
+        float best = kInf;
+        int x = grid->xOf(idx);
+        int y = grid->yOf(idx);
+        for (int d = 0; d < 8; ++d) {
+            int nx = x + SearchGrid::dirDx[d];
+            int ny = y + SearchGrid::dirDy[d];
+            if (!grid->inBounds(nx, ny)) continue;
+            int next = grid->index(nx, ny);
+            best = std::min(best, enterCost(next) + g(next));
+        }
+        rhsValues[idx] = best;
+    }
+
+    // Consistent cells are dropped lazily when popped
+    if (gValues[idx] != rhsValues[idx]) {
+        open.push_back({calculateKey(idx), idx});
+        std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+    }
+}
+
+void DStarLite::updateNeighbours(int idx)
+{
+    int x = grid->xOf(idx);
+    int y = grid->yOf(idx);
+    for (int d = 0; d < 8; ++d) {
+        int nx = x + SearchGrid::dirDx[d];
+        int ny = y + SearchGrid::dirDy[d];
+        if (grid->inBounds(nx, ny)) updateVertex(grid->index(nx, ny));
+    }
+}
+
+bool DStarLite::topKey(Key &key)
+{
+    // Skip entries of cells that became consistent after they were queued
+    while (!open.empty()) {
+        int idx = open.front().index;
+        if (g(idx) != rhs(idx)) {
+            key = open.front().key;
+            return true;
+        }
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        open.pop_back();
+    }
+    return false;
+}
+
+void DStarLite::computeShortestPath()
+{
+    // Keys are float sums, so near-ties with the start's key are settled as well instead of
+    // trusting the last bit of rounding; settling a few extra cells never hurts correctness
+    Key top;
+    while (topKey(top)) {
+        Key startKey = calculateKey(start);
+        float slack = startKey.k1 == kInf ? 0.0f : 1e-4f * std::max(1.0f, startKey.k1);
+        if (top.k1 > startKey.k1 + slack && rhs(start) == g(start)) break;
+
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        int u = open.back().index;
+        open.pop_back();
+        ++expanded;
+
+        Key fresh = calculateKey(u);
+        if (top < fresh) {
+            open.push_back({fresh, u});
+            std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        } else if (gValues[u] > rhsValues[u]) {
+            gValues[u] = rhsValues[u];
+            updateNeighbours(u);
+        } else {
+            gValues[u] = kInf;
+            updateVertex(u);
+            updateNeighbours(u);
+        }
+    }
+}
+
+std::vector<int> DStarLite::extractPath() const
+{
+    std::vector<int> path;
+    if (g(start) == kInf) return path;
+
+    // Follow the cheapest successor; bounded in case of ties on a plateau
+    int current = start;
+    for (int steps = 0; current != goal && steps < grid->size(); ++steps) {
+        int x = grid->xOf(current);
+        int y = grid->yOf(current);
+        int bestDir = -1;
+        float best = kInf;
+        for (int d = 0; d < 8; ++d) {
+            int nx = x + SearchGrid::dirDx[d];
+            int ny = y + SearchGrid::dirDy[d];
+            if (!grid->inBounds(nx, ny)) continue;
+            int next = grid->index(nx, ny);
+            float cost = enterCost(next) + g(next);
+            if (cost < best) {
+                best = cost;
+                bestDir = d;
+            }
+        }
+        if (bestDir < 0) return {};
+        path.push_back(bestDir);
+        current = grid->index(x + SearchGrid::dirDx[bestDir], y + SearchGrid::dirDy[bestDir]);
+    }
+    if (current != goal) return {};
+    return path;
+}
@@ -0,0 +1,73 @@
+#ifndef DSTARLITE_H
+#define DSTARLITE_H
+
+#include "searchgrid.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief D* Lite planner that keeps its search state for one goal and repairs it when blockers change.
+ *
+ * The search runs backwards from the goal, so the protagonist walking along the path
+ * only shifts the key modifier, and a changed cell only re-evaluates its eight
+ * neighbours plus whatever part of the tree actually depended on it. Per-cell state
+ * is generation-stamped like SearchWorkspace, so a fresh plan resets in O(1).
+ */
+class DStarLite {
+public:
+    /**
+     * @brief Path from start to goal, reusing the previous plan where possible.
+     * changedCells lists cells whose blocker bits changed since the last call; pass nullptr
+     * when that is unknown and a fresh search is needed. Returns 0-7 directions, empty if unreachable.
+     */
+    std::vector<int> replan(const SearchGrid &grid, int start, int goal, uint8_t blockerMask,
+                            const std::vector<int> *changedCells);
+
+    void reset() noexcept { planned = false; }
+    // Cells the last replan() popped and settled
+    uint64_t getExpanded() const noexcept { return expanded; }
+    bool isPlannedFor(int goalCell, uint8_t mask) const noexcept { return planned && goal == goalCell && blockerMask == mask; }
+
+private:
+    struct Key {
+        float k1;
+        float k2;
+        bool operator<(const Key &other) const { return k1 < other.k1 || (k1 == other.k1 && k2 < other.k2); }
+    };
+    struct OpenEntry {
+        Key key;
+        int index;
+        bool operator>(const OpenEntry &other) const { return other.key < key; }
+    };
+
+    void begin(int start, int goal);
+    float g(int idx) const noexcept;
+    float rhs(int idx) const noexcept;
+    void touch(int idx);
+    float enterCost(int idx) const noexcept;
+    float heuristic(int a, int b) const noexcept;
+    Key calculateKey(int idx) const noexcept;
+    void updateVertex(int idx);
+    void updateNeighbours(int idx);
+    void computeShortestPath();
+    bool topKey(Key &key);
+    std::vector<int> extractPath() const;
+
+    const SearchGrid *grid = nullptr;
+    uint64_t levelId = 0;
+    int start = -1;
+    int lastStart = -1;
+    int goal = -1;
+    uint8_t blockerMask = 0;
+    float km = 0.0f;
+    bool planned = false;
+    uint64_t expanded = 0;
+
+    std::vector<float> gValues;
+    std::vector<float> rhsValues;
+    std::vector<uint32_t> stamp;
+    uint32_t generation = 0;
+    std::vector<OpenEntry> open;
+};
+
+#endif // DSTARLITE_H
@@ -0,0 +1,84 @@
+#include "flowfield.h"
+#include <utility>
+
+void FlowField::retarget(const SearchGrid &g, int goal, uint8_t blockerMask)
+{
+    if (grid != &g) {
+        grid = &g;
+        publishedGoal = -1;
+        building = false;
+    }
+    targetGoal = (goal >= 0 && goal < g.size() && g.isPassable(goal)) ? goal : -1;
+    targetMask = blockerMask;
+}
+
+bool FlowField::isCurrent() const noexcept
+{
+    return grid && publishedGoal == targetGoal && publishedMask == targetMask
+           && publishedVersion == grid->getBlockerVersion();
+}
+
+void FlowField::beginPass()
+{
+    passGoal = targetGoal;
+    passMask = targetMask;
+    passVersion = grid->getBlockerVersion();
+    next.setOpenListKind(grid->getOpenListKind());
+    next.begin(grid->size());
+    next.reach(passGoal, 0.0f, passGoal);
+    next.f[passGoal] = 0.0f;
+    next.push(0.0f, passGoal);
+    building = true;
+}
+
+bool FlowField::advance(int cellBudget)
+{
+    if (!grid || targetGoal < 0) return false;
+    if (!building) {
+        // A pass runs to the end even if the goal moves again; restarting on every step would never finish
+        if (isCurrent()) return false;
+        beginPass();
+    }
+
+    const SearchGrid &g = *grid;
+    for (int spent = 0; spent < cellBudget && !next.openEmpty(); ++spent) {
+        SearchWorkspace::OpenEntry cell = next.pop();
+        if (cell.f > next.g[cell.index]) continue;
+        // Agents may step off a blocked cell but never through one; the goal is always open
+        if (cell.index != passGoal && g.isBlocked(cell.index, passMask)) continue;
+
+        // Every neighbour reaches the goal by stepping onto this cell, paying its cost
+        float viaCell = next.g[cell.index] + g.getStepCost(cell.index);
+        int cx = g.xOf(cell.index);
+        int cy = g.yOf(cell.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!g.inBounds(nx, ny)) continue;
+
+            int from = g.index(nx, ny);
+            if (!g.isPassable(from)) continue;
+            if (next.isReached(from) && viaCell >= next.g[from]) continue;
+
+            next.reach(from, viaCell, cell.index);
+            next.f[from] = viaCell;
+            next.push(viaCell, from);
+        }
+    }
+    if (!next.openEmpty()) return false;
+
+    std::swap(current, next);
+    publishedGoal = passGoal;
+    publishedMask = passMask;
+    publishedVersion = passVersion;
+    building = false;
+    return true;
+}
+
+float FlowField::costToGoal(int cell) const noexcept
+{
+    if (!isReady() || cell < 0 || cell >= grid->size() || !current.isReached(cell)) {
+        return std::numeric_limits<float>::infinity();
+    }
+    return current.g[cell];
+}
@@ -0,0 +1,63 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Cost to one goal from every cell, shared as an exact heuristic by any number of agents.
+ *
+ * One integration pass (a Dijkstra flood outward from the goal over the reversed moves)
+ * gives each cell its cost to the goal, so CooperativePlanner agents heading for that goal
+ * look their heuristic up instead of each keeping a GoalDistance. Blocked cells are never
+ * routed through, but an agent standing on one still gets a cost out.
+ *
+ * The field is double-buffered: retarget() records where the goal is now, and advance()
+ * spends a bounded number of cells on the next pass while agents keep reading the last
+ * finished one. Regeneration is not incremental: every pass is a full re-flood from the
+ * goal, only spread over as many frames as the slice budget needs. When a pass completes it
+ * is published, and if the goal (or the blockers) moved meanwhile the next one starts.
+ */
+class FlowField {
+public:
+    static constexpr int defaultSliceCells = 16384;
+
+    // Goal for the next pass. A different grid discards everything computed so far.
+    void retarget(const SearchGrid &grid, int goal, uint8_t blockerMask);
+
+    // Runs up to cellBudget cells of integration; returns true when a new field was published.
+    bool advance(int cellBudget = defaultSliceCells);
+
+    float costToGoal(int cell) const noexcept;
+
+    bool isReady() const noexcept { return publishedGoal >= 0; }
+    bool isCurrent() const noexcept;
+    int getGoal() const noexcept { return publishedGoal; }
+    // Blockers the published field was flooded with
+    uint8_t getBlockerMask() const noexcept { return publishedMask; }
+    uint64_t getBlockerVersion() const noexcept { return publishedVersion; }
+
+private:
+    void beginPass();
+
+    const SearchGrid *grid = nullptr;
+    int targetGoal = -1;
+    uint8_t targetMask = 0;
+
+    // Finished field agents read from
+    SearchWorkspace current;
+    int publishedGoal = -1;
+    uint8_t publishedMask = 0;
+    uint64_t publishedVersion = 0;
+
+    // Pass in progress
+    SearchWorkspace next;
+    bool building = false;
+    int passGoal = -1;
+    uint8_t passMask = 0;
+    uint64_t passVersion = 0;
+};
+
+#endif // FLOWFIELD_H
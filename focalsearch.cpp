@@ -0,0 +1,114 @@
+#include "focalsearch.h"
+#include "landmarks.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+FocalSearch::FocalSearch(const SearchGrid &grid, SearchWorkspace &workspace)
+    : grid(grid), ws(workspace), goal(-1)
+{}
+
+float FocalSearch::heuristic(int idx) const noexcept
+{
+    int dx = std::abs(grid.xOf(idx) - grid.xOf(goal));
+    int dy = std::abs(grid.yOf(idx) - grid.yOf(goal));
+    float chebyshev = grid.getMinStepCost() * static_cast<float>(std::max(dx, dy));
+    const LandmarkTable *landmarks = grid.getLandmarks();
+    return landmarks ? std::max(chebyshev, landmarks->lowerBound(idx, goal)) : chebyshev;
+}
+
+std::vector<int> FocalSearch::findPath(int start, int goalIdx, uint8_t mask, float epsilon)
+{
+    goal = goalIdx;
+    if (start == goal || !grid.isPassable(goal)) return {};
+
+    const auto byF = std::greater<SearchWorkspace::OpenEntry>();
+    const auto byH = std::greater<FocalEntry>();
+    // An expanded cell's f is set to -inf, which turns every entry still queued for it stale
+    const float closed = -std::numeric_limits<float>::infinity();
+
+    ws.begin(grid.size());
+    ws.reach(start, 0.0f, start);
+    ws.f[start] = heuristic(start);
+    open.assign(1, {ws.f[start], start});
+    waiting.clear();
+    focal.assign(1, {ws.f[start], ws.f[start], start});
+
+    while (!grid.isCancelled()) {
+        while (!open.empty() && isStale(open.front().f, open.front().index)) {
+            std::pop_heap(open.begin(), open.end(), byF);
+            open.pop_back();
+        }
+        if (open.empty()) return {};
+
+        // The lowest open f only grows, so cells let into the focal list stay within the bound
+        float bound = epsilon * open.front().f;
+        while (!waiting.empty() && waiting.front().f <= bound) {
+            SearchWorkspace::OpenEntry entry = waiting.front();
+            std::pop_heap(waiting.begin(), waiting.end(), byF);
+            waiting.pop_back();
+            if (!isStale(entry.f, entry.index)) {
+                focal.push_back({entry.f - ws.g[entry.index], entry.f, entry.index});
+                std::push_heap(focal.begin(), focal.end(), byH);
+            }
+        }
+        while (!focal.empty() && isStale(focal.front().f, focal.front().index)) {
+            std::pop_heap(focal.begin(), focal.end(), byH);
+            focal.pop_back();
+        }
+
+        // The cell with the lowest f always qualifies, so focal is only empty if that cell got lost
+        int current = focal.empty() ? open.front().index : focal.front().index;
+        if (!focal.empty()) {
+            std::pop_heap(focal.begin(), focal.end(), byH);
+            focal.pop_back();
+        }
+        ++ws.expanded;
+        if (current == goal) return reconstructPath(start);
+        ws.f[current] = closed;
+
+        int cx = grid.xOf(current);
+        int cy = grid.yOf(current);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            int next = grid.index(nx, ny);
+            float step = next == goal ? grid.getStepCost(next) : grid.getStepCost(next, mask);
+            if (step == std::numeric_limits<float>::infinity()) continue;
+
+            float newG = ws.g[current] + step;
+            if (ws.isReached(next) && newG >= ws.g[next]) continue;
+
+            // Reopens a closed cell too: expanding out of f order can reach a cell early on a worse route
+            float h = heuristic(next);
+            ws.reach(next, newG, current);
+            ws.f[next] = newG + h;
+            open.push_back({ws.f[next], next});
+            std::push_heap(open.begin(), open.end(), byF);
+            if (ws.f[next] <= bound) {
+                focal.push_back({h, ws.f[next], next});
+                std::push_heap(focal.begin(), focal.end(), byH);
+            } else {
+                waiting.push_back({ws.f[next], next});
+                std::push_heap(waiting.begin(), waiting.end(), byF);
+            }
+        }
+    }
+
+    return {};
+}
+
+std::vector<int> FocalSearch::reconstructPath(int start) const
+{
+    std::vector<int> path;
+    for (int current = goal; current != start; ) {
+        int prev = static_cast<int>(ws.parent[current]);
+        path.push_back(SearchGrid::directionBetween(grid.xOf(prev), grid.yOf(prev), grid.xOf(current), grid.yOf(current)));
+        current = prev;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
@@ -0,0 +1,46 @@
+#ifndef FOCALSEARCH_H
+#define FOCALSEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Focal search (A*-epsilon): bounded-suboptimal A* that picks among near-best cells by distance to go.
+ *
+ * Every open cell with f <= epsilon * (lowest open f) is in the focal list, and the one
+ * estimated closest to the goal is expanded next. Since the lowest open f never exceeds
+ * the optimal cost, the path found costs at most epsilon times the optimum. Unlike
+ * weighted A*, which inflates every estimate, it stays close to the cheapest route while
+ * still heading straight for the goal when many cells tie.
+ */
+class FocalSearch {
+public:
+    FocalSearch(const SearchGrid &grid, SearchWorkspace &workspace);
+
+    // Same contract as SearchGrid::findPath: 0-7 directions, empty if unreachable.
+    std::vector<int> findPath(int start, int goal, uint8_t blockerMask, float epsilon);
+
+private:
+    struct FocalEntry {
+        float h;
+        float f;
+        int index;
+        bool operator>(const FocalEntry &other) const { return h != other.h ? h > other.h : f > other.f; }
+    };
+
+    float heuristic(int idx) const noexcept;
+    std::vector<int> reconstructPath(int start) const;
+    bool isStale(float f, int idx) const noexcept { return f > ws.f[idx]; }
+
+    const SearchGrid &grid;
+    SearchWorkspace &ws;
+    int goal;
+
+    std::vector<SearchWorkspace::OpenEntry> open;    // every open cell, by f; its top bounds the focal list
+    std::vector<SearchWorkspace::OpenEntry> waiting; // open cells above the bound, by f
+    std::vector<FocalEntry> focal;                   // open cells within the bound, by h
+};
+
+#endif // FOCALSEARCH_H
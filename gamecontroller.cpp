@@ -12,23 +12,39 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDebug>
+#include <algorithm>
 #include <limits>
 #include <cmath>
 #include <random>
 #include <memory>
 
+namespace {
+// Weight of the quick hover search; the path a click would take replaces it once the cursor rests
+constexpr float kPreviewEpsilon = 3.0f;
+constexpr int kPreviewRestMs = 200;
+}
+
 GameController::GameController(QWidget *parent)
     : QMainWindow(parent),
     model(new GameModel(this)),
     autoPlayTimer(new QTimer(this)),
+    planningService(new PathPlanningService(this)),
     commandMoveTimer(new QTimer(this)),
-    commandPathIndex(0)
+    commandPathIndex(0),
+    commandWaypointIndex(0),
+    commandAvoidPortal(false),
+    commandGoal(-1),
+    commandBlockerEpoch(0),
+    anytimeBudgetUs(0),
+    anytimeTimer(new QTimer(this)),
+    anytimeShownBest(-1),
+    previewRestTimer(new QTimer(this)),
+    previewX(-1),
+    previewY(-1)
 {
-    std::function<bool(const Node&, const Node&)> nodeComparator = [](const Node &a, const Node &b) {
-        return a.f > b.f;
-    };
-
-    autoPlayStrategy = std::make_unique<DefaultAutoPlayStrategy>(nodeComparator);
+    auto strategy = std::make_unique<DefaultAutoPlayStrategy>();
+    strategy->setPlanningService(planningService);
+    autoPlayStrategy = std::move(strategy);
 
     setupModel();
     setupViews();
@@ -40,10 +56,27 @@ GameController::GameController(QWidget *parent)
     // commandMoveTimer setup
     commandMoveTimer->setInterval(300); // Slightly faster or similar speed as autoplay
     connect(commandMoveTimer, &QTimer::timeout, this, &GameController::handleCommandMoveStep);
+
+    // One anytime slice per frame
+    anytimeTimer->setInterval(16);
+    connect(anytimeTimer, &QTimer::timeout, this, &GameController::runAnytimeSlice);
+
+    previewRestTimer->setSingleShot(true);
+    previewRestTimer->setInterval(kPreviewRestMs);
+    connect(previewRestTimer, &QTimer::timeout, this, [this]() {
+        // A path from a cell the protagonist is about to leave is stale on arrival; wait until it stops
+        if (commandMoveTimer->isActive() || autoPlayActive) {
+            previewRestTimer->start();
+            return;
+        }
+        startPathPreview(true);
+    });
 }
 
 GameController::~GameController()
 {
+    // Stop running searches now; the service waits for its workers when it is destroyed
+    planningService->cancelAll();
 }
 
 void GameController::show()
@@ -84,10 +117,12 @@ void GameController::setupConnections()
 
     connect(graphicView, &GameView::moveRequest, this, [this](int dx, int dy){
         // Manual move using arrow keys (or UI buttons)
+        crossLevelLegs.clear();
         moveProtagonist(dx, dy);
     });
     connect(graphicView, &GameView::autoPlayRequest, this, &GameController::startAutoPlay);
     connect(graphicView, &GameView::tileSelected, this, &GameController::onTileSelected);
+    connect(graphicView, &GameView::tileHovered, this, &GameController::onTileHovered);
 }
 
 void GameController::createActions()
@@ -139,6 +174,9 @@ void GameController::setupCommands()
             int x = args[0].toInt();
             int y = args[1].toInt();
             gotoXY(x,y);
+        } else if (args.size() == 3) {
+            // "goto <level> <x> <y>", levels counted from 1 as in the status panel
+            gotoLevelXY(args[0].toInt() - 1, args[1].toInt(), args[2].toInt());
         }
     });
 
@@ -150,6 +188,89 @@ void GameController::setupCommands()
         takeNearestHealthPack();
     });
 
+    commandParser.addCommand("path stats", [this](QStringList){
+        // Click, goto and autoplay searches run on worker copies that share the level's cache
+        PathCache::Stats stats = model->getSearchGrid()->getPathCache().getStats();
+        textView->appendMessage(QString("Path cache: %1 hits, %2 sub-path hits, %3 misses, %4 evictions, %5 routes in %6 KB")
+                                    .arg(stats.hits).arg(stats.subPathHits).arg(stats.misses).arg(stats.evictions)
+                                    .arg(stats.entries).arg(stats.bytes / 1024));
+        if (lastCommandQuery.steps > 0 || lastCommandQuery.expanded > 0) {
+            textView->appendMessage(describeQuery(lastCommandQuery));
+        }
+        // An autoplay decision may run a flood, several searches and a repair; they are summed
+        SearchGrid::QueryStats decision = autoPlayStrategy->getLastQuery();
+        if (decision.micros > 0.0) {
+            textView->appendMessage(QString("Last autoplay decision: %1 cells expanded, %2 steps costing %3, %4 ms")
+                                        .arg(decision.expanded).arg(decision.steps).arg(decision.cost, 0, 'f', 3)
+                                        .arg(decision.micros / 1000.0, 0, 'f', 3));
+        }
+    });
+
+    // Bounded-suboptimal routing: "search goto 1.5 focal", "search auto 2", "search goto 1" for optimal
+    commandParser.addCommand("search", [this](QStringList args){
+        auto describe = [this](const QString &name, SearchPolicy policy) {
+            // Bucket keys are rounded, so A* over the bucket queue may miss the optimum by one bucket width
+            if (policy.epsilon <= 1.0f && model->getOpenListKind() == OpenListKind::BucketQueue) {
+                return QString("%1: optimal to within %2 energy").arg(name).arg(1.0f / BucketQueue::keyScale, 0, 'f', 4);
+            }
+            if (policy.epsilon <= 1.0f) return QString("%1: optimal").arg(name);
+            return QString("%1: %2, paths within %3x optimal").arg(name)
+                .arg(QString(policy.focal ? "focal search" : "weighted A*")).arg(policy.epsilon, 0, 'f', 2);
+        };
+        if (args.size() >= 2 && (args[0] == "goto" || args[0] == "auto")) {
+            bool ok = false;
+            float epsilon = args[1].toFloat(&ok);
+            if (ok && epsilon >= 1.0f) {
+                model->setSearchPolicy(args[0] == "goto" ? GameModel::QueryKind::Command : GameModel::QueryKind::AutoPlay,
+                                       {epsilon, args.size() >= 3 && args[2] == "focal"});
+            }
+        }
+        textView->appendMessage(describe("Goto and clicks", model->getSearchPolicy(GameModel::QueryKind::Command)));
+        textView->appendMessage(describe("Autoplay", model->getSearchPolicy(GameModel::QueryKind::AutoPlay)));
+    });
+
+    // Open list used by path searches: bucket queue (default) or the binary heap, for comparing the two
+    commandParser.addCommand("queue", [this](QStringList args){
+        if (args.size() == 1 && (args[0] == "heap" || args[0] == "bucket")) {
+            model->setOpenListKind(args[0] == "heap" ? OpenListKind::BinaryHeap : OpenListKind::BucketQueue);
+        }
+        textView->appendMessage(model->getOpenListKind() == OpenListKind::BinaryHeap
+                                    ? "Path searches use the binary heap open list."
+                                    : "Path searches use the bucket queue open list.");
+    });
+
+    // Anytime click/goto: start walking a partial path after one slice of this many microseconds
+    commandParser.addCommand("anytime", [this](QStringList args){
+        if (args.size() == 1) {
+            bool ok = false;
+            int budget = args[0].toInt(&ok);
+            if (args[0] == "off") {
+                anytimeBudgetUs = 0;
+            } else if (ok && budget > 0) {
+                anytimeBudgetUs = budget;
+            }
+        }
+        textView->appendMessage(anytimeBudgetUs > 0
+                                    ? QString("Anytime routing on: %1 us per slice.").arg(anytimeBudgetUs)
+                                    : QString("Anytime routing off."));
+    });
+
+    // Autoplay detours around enemies and poison: energy worth paying per hit point at risk
+    commandParser.addCommand("danger", [this](QStringList args){
+        if (args.size() == 1) {
+            bool ok = false;
+            float weight = args[0].toFloat(&ok);
+            if (args[0] == "off") {
+                model->setDangerWeight(0.0f);
+            } else if (ok && weight >= 0.0f) {
+                model->setDangerWeight(weight);
+            }
+        }
+        textView->appendMessage(model->getDangerWeight() > 0.0f
+                                    ? QString("Danger avoidance on: %1 energy per hit point at risk.").arg(model->getDangerWeight())
+                                    : QString("Danger avoidance off."));
+    });
+
     commandParser.addCommand("help", [this](QStringList){ printHelp(); });
 }
 
@@ -174,63 +295,232 @@ void GameController::gotoXY(int x, int y)
 {
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
     // Direct path movement to (x,y) with animation
-    std::vector<int> path = computeDirectPath(model->getProtagonist()->getXPos(),
-                                              model->getProtagonist()->getYPos(),
-                                              x,y);
-    if (!path.empty()) {
-        startCommandPathMovement(path);
-    } else {
+    startRouteTo(x, y, false, [this]() {
         textView->appendMessage("No path found to the specified tile.");
-    }
+    });
 }
 
-void GameController::attackNearestEnemy()
+void GameController::gotoLevelXY(int level, int x, int y)
 {
+    if (level == model->getCurrentLevel()) {
+        gotoXY(x, y);
+        return;
+    }
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
 
-    EnemyWrapper* e = findNearestUndefeatedEnemy();
-    if (!e) {
-        textView->appendMessage("No enemies found.");
+    if (level < 0 || level >= model->getLevelFiles().size() || !refreshPortalGraph(level)) {
+        textView->appendMessage(QString("There is no level %1.").arg(level + 1));
+        return;
+    }
+    auto target = levelCache.value(level);
+    if (x < 0 || x >= target->cols || y < 0 || y >= target->rows) {
+        textView->appendMessage("No path found to the specified tile.");
         return;
     }
 
+    SearchGrid *grid = model->getSearchGrid();
     auto *p = model->getProtagonist();
-    std::vector<int> path = computeDirectPath(p->getXPos(), p->getYPos(),
-                                              e->getXPos(), e->getYPos(),
-                                              true /*avoid portal if enemies remain*/);
-    if (path.empty()) {
-        textView->appendMessage("No path found to the nearest enemy.");
+    PortalGraph::Route route = portalGraph.findRoute(model->getCurrentLevel(), *grid, grid->index(p->getXPos(), p->getYPos()),
+                                                     model->getBlockerMask(true), level, y * target->cols + x, false);
+    if (!route.found()) {
+        // Leaving a level needs all its enemies defeated; a goto never fights its way through
+        PortalGraph::Route blocked = portalGraph.findRoute(model->getCurrentLevel(), *grid, grid->index(p->getXPos(), p->getYPos()),
+                                                           model->getBlockerMask(true), level, y * target->cols + x, true);
+        if (blocked.found() && !blocked.levelsToClear.empty()) {
+            textView->appendMessage(QString("Clear level %1 first: its portals stay shut while enemies live.")
+                                        .arg(blocked.levelsToClear.front() + 1));
+        } else {
+            textView->appendMessage("No path found to the specified tile.");
+        }
         return;
     }
 
-    textView->appendMessage("Moving towards enemy...");
-    startCommandPathMovement(path);
+    // Every leg ends on a portal except a final walk on the goal level
+    size_t portals = route.legs.size() - (route.legs.back().level == level ? 1 : 0);
+    textView->appendMessage(QString("Routing to level %1 through %2 portal(s), %3 energy.")
+                                .arg(level + 1).arg(portals).arg(route.cost, 0, 'f', 2));
+    crossLevelLegs = std::move(route.legs);
+    crossLevelLegIndex = 0;
+    continueCrossLevelRoute();
 }
 
-void GameController::takeNearestHealthPack()
+bool GameController::refreshPortalGraph(int upToLevel)
+{
+    if (!gameStateManager.cacheLevel(upToLevel, levelCache)) return false;
+
+    // A restart or load dropped cached levels: their portals may be anywhere now
+    for (auto it = portalGraphLevels.begin(); it != portalGraphLevels.end(); ++it) {
+        if (levelCache.value(it.key()) != it.value()) {
+            portalGraph.clear();
+            portalGraphLevels.clear();
+            break;
+        }
+    }
+
+    bool changed = false;
+    for (auto it = levelCache.begin(); it != levelCache.end(); ++it) {
+        const std::shared_ptr<GameStateManager::CachedLevel> &cached = it.value();
+        if (portalGraphLevels.value(it.key()) == cached) continue;
+
+        // Levels are rebuilt from the cache when entered, so its enemies are what a visit meets
+        bool cleared = true;
+        for (auto &e : cached->enemies) {
+            if (!e->isDefeated()) cleared = false;
+        }
+        std::vector<PortalGraph::Link> links;
+        for (auto &portal : cached->portals) {
+            auto target = levelCache.value(portal->getTargetLevel());
+            int targetCell = -1;
+            if (target && portal->getTargetX() >= 0 && portal->getTargetX() < target->cols
+                && portal->getTargetY() >= 0 && portal->getTargetY() < target->rows) {
+                targetCell = portal->getTargetY() * target->cols + portal->getTargetX();
+            }
+            links.push_back({portal->getYPos() * cached->cols + portal->getXPos(), portal->getTargetLevel(), targetCell});
+        }
+        portalGraph.setLevel(it.key(), std::make_shared<SearchGrid>(cached->tiles, cached->rows, cached->cols),
+                             std::move(links), cleared);
+        portalGraphLevels[it.key()] = cached;
+        changed = true;
+    }
+    if (changed) portalGraph.build();
+    portalGraph.setCleared(model->getCurrentLevel(), !model->hasLivingEnemies());
+    return portalGraph.hasLevel(model->getCurrentLevel()) && portalGraph.hasLevel(upToLevel);
+}
+
+bool GameController::continueCrossLevelRoute()
+{
+    SearchGrid *grid = model->getSearchGrid();
+    auto *p = model->getProtagonist();
+    while (crossLevelLegIndex < crossLevelLegs.size()) {
+        const PortalGraph::Leg &leg = crossLevelLegs[crossLevelLegIndex];
+        // Something else moved us to another level
+        if (leg.level != model->getCurrentLevel()) break;
+        ++crossLevelLegIndex;
+        bool last = crossLevelLegIndex == crossLevelLegs.size();
+
+        int here = grid->index(p->getXPos(), p->getYPos());
+        if (leg.to == here) {
+            if (last) break;
+            // Arrived on the portal we have to take: step off to the cheapest neighbour and back on
+            int bestDir = -1;
+            float bestCost = std::numeric_limits<float>::infinity();
+            for (int d = 0; d < 8; ++d) {
+                int nx = p->getXPos() + SearchGrid::dirDx[d];
+                int ny = p->getYPos() + SearchGrid::dirDy[d];
+                if (!grid->inBounds(nx, ny)) continue;
+                float cost = grid->getStepCost(grid->index(nx, ny), model->getBlockerMask(false));
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestDir = d;
+                }
+            }
+            if (bestDir < 0) break;
+            commandWaypoints.clear();
+            startCommandPathMovement({bestDir, (bestDir + 4) % 8});
+            return true;
+        }
+
+        startRouteTo(grid->xOf(leg.to), grid->yOf(leg.to), true, [this]() {
+            crossLevelLegs.clear();
+            textView->appendMessage("No path found to the next portal.");
+        });
+        return true;
+    }
+    crossLevelLegs.clear();
+    crossLevelLegIndex = 0;
+    return false;
+}
+
+void GameController::aimAutoPlayExit()
+{
+    // Levels are chained one after another, so the way to the last level always leaves through the
+    // portal to the next one; no level beyond it has to be generated before autoplay gets there
+    int exit = -1;
+    int finalLevel = model->getLevelFiles().size() - 1;
+    if (model->getCurrentLevel() < finalLevel) {
+        for (auto &portal : model->getPortals()) {
+            if (portal->getTargetLevel() == model->getCurrentLevel() + 1) {
+                exit = model->getSearchGrid()->index(portal->getXPos(), portal->getYPos());
+                break;
+            }
+        }
+    }
+    model->setExitPortal(exit);
+}
+
+void GameController::attackNearestEnemy()
 {
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
 
-    HealthPack* hp = findNearestHealthPack();
-    if (!hp) {
-        textView->appendMessage("No health packs found.");
+    if (!model->hasLivingEnemies()) {
+        planningService->cancel(PathPlanningService::CommandChannel);
+        textView->appendMessage("No enemies found.");
         return;
     }
+    SearchGrid *grid = model->getSearchGrid();
+    std::vector<int> cells;
+    for (auto &e : model->getEnemies()) {
+        if (!e->isDefeated()) cells.push_back(grid->index(e->getXPos(), e->getYPos()));
+    }
+    startNearestRoute(cells, "Moving towards enemy...", "No path found to the nearest enemy.");
+}
 
-    auto *p = model->getProtagonist();
-    std::vector<int> path = computeDirectPath(p->getXPos(), p->getYPos(),
-                                              hp->getXPos(), hp->getYPos(),
-                                              true /*avoid portal if enemies remain*/);
-    if (path.empty()) {
-        textView->appendMessage("No path found to the nearest health pack.");
+void GameController::takeNearestHealthPack()
+{
+    stopAutoPlay();
+    commandMoveTimer->stop();
+    crossLevelLegs.clear();
+
+    if (model->getHealthPacks().empty()) {
+        planningService->cancel(PathPlanningService::CommandChannel);
+        textView->appendMessage("No health packs found.");
         return;
     }
+    SearchGrid *grid = model->getSearchGrid();
+    std::vector<int> cells;
+    for (auto &hp : model->getHealthPacks()) {
+        cells.push_back(grid->index(hp->getXPos(), hp->getYPos()));
+    }
+    startNearestRoute(cells, "Moving towards health pack...", "No path found to the nearest health pack.");
+}
 
-    textView->appendMessage("Moving towards health pack...");
-    startCommandPathMovement(path);
+void GameController::startNearestRoute(const std::vector<int> &cells, const QString &moving, const QString &noPath)
+{
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    auto *p = model->getProtagonist();
+    cancelAnytimeRoute();
+    commandWaypoints.clear();
+    commandAvoidPortal = true;
+
+    int start = grid->index(p->getXPos(), p->getYPos());
+    uint8_t mask = model->getBlockerMask(true);
+    uint64_t epoch = model->getBlockerEpoch();
+    // One flood settles every candidate; the closest by walking distance wins, and the flood
+    // already holds its shortest route, so it is walked without a second search
+    planningService->submit<std::vector<int>>(PathPlanningService::CommandChannel, grid,
+        [start, cells, mask](SearchGrid &worker) {
+            DistanceMap distances;
+            distances.compute(worker, start, cells, mask);
+            int nearest = distances.nearest(cells);
+            return nearest < 0 ? std::vector<int>() : distances.pathTo(cells[nearest]);
+        },
+        [this, grid, start, epoch, moving, noPath](std::vector<int> path) {
+            auto *p = model->getProtagonist();
+            if (model->getSharedSearchGrid() != grid || grid->index(p->getXPos(), p->getYPos()) != start) return;
+            if (path.empty()) {
+                textView->appendMessage(noPath);
+                return;
+            }
+            startCommandPathMovement(path);
+            commandBlockerEpoch = epoch;
+            textView->appendMessage(moving);
+        });
 }
 
 void GameController::switchView()
@@ -243,6 +533,7 @@ void GameController::startAutoPlay()
 {
     // Stop any manual command movements
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
 
     if (autoPlayActive) {
         stopAutoPlay();
@@ -256,6 +547,7 @@ void GameController::startAutoPlay()
         return;
     }
 
+    aimAutoPlayExit();
     autoPlayStrategy->start(model);
     autoPlayStrategy->decideNextAction();
     autoPlayActive = true;
@@ -283,10 +575,13 @@ void GameController::handleAutoPlayStep()
     AutoPlayMove move = autoPlayStrategy->nextStep();
 
     if (move.dx == 0 && move.dy == 0) {
+        // The next path is still being planned on a worker: wait for it
+        if (autoPlayStrategy->isPlanning()) return;
         // No steps in current path, decide next action
         autoPlayStrategy->decideNextAction();
         move = autoPlayStrategy->nextStep();
         if (move.dx == 0 && move.dy == 0) {
+            if (autoPlayStrategy->isPlanning()) return;
             // Still no steps: stop autoplay
             stopAutoPlay();
             return;
@@ -296,7 +591,8 @@ void GameController::handleAutoPlayStep()
     // Perform the move
     moveProtagonist(move.dx, move.dy);
 
-    // Check if protagonist died after move
+    // Check if protagonist died after move; a portal may have replaced it with the next level's
+    p = model->getProtagonist();
     if (p->getHealth() <= 0 || p->getEnergy() <= 0) {
         stopAutoPlay();
         qDebug() << "GAME OVER3";
@@ -320,7 +616,9 @@ void GameController::loadGame()
 {
     QString fileName = QFileDialog::getOpenFileName(this, tr("Load Game"), "", tr("Game Files (*.game)"));
     if (!fileName.isEmpty()) {
+        crossLevelLegs.clear();
         if (gameStateManager.loadGameFromFile(model, levelCache, fileName)) {
+            startPoiDistances();
             QMessageBox::information(this, tr("Load Game"), tr("Game loaded successfully."));
         } else {
             QMessageBox::warning(this, tr("Load Game"), tr("Failed to load the game."));
@@ -332,18 +630,24 @@ void GameController::newGame()
 {
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
     if (!gameStateManager.newGame(model, levelCache)) {
         qWarning() << "Failed to start new game.";
+        return;
     }
+    startPoiDistances();
 }
 
 void GameController::restartGame()
 {
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
     if (!gameStateManager.restartGame(model, levelCache)) {
         qWarning() << "Failed to restart game.";
+        return;
     }
+    startPoiDistances();
 }
 
 void GameController::moveProtagonist(int dx, int dy)
@@ -409,6 +713,7 @@ void GameController::checkForEncounters()
                         xE->hit();
                     }
 
+                    model->updateEnemyBlocker(xE, xE->getOldX(), xE->getOldY());
                     emit model->modelUpdated();
                 } else if (xE->getTimesHit() == 1) {
                     float healthCost = e->getStrength();
@@ -416,6 +721,7 @@ void GameController::checkForEncounters()
                     if (newHealth > 0) {
                         p->setHealth(newHealth);
                         xE->hit(); // second hit defeats XEnemy
+                        model->updateEnemyBlocker(xE, xE->getXPos(), xE->getYPos());
                         emit model->modelUpdated();
                     } else {
                         p->setHealth(0);
@@ -432,6 +738,7 @@ void GameController::checkForEncounters()
                 if (newHealth > 0) {
                     p->setHealth(newHealth);
                     e->setDefeated(true);
+                    model->updateEnemyBlocker(e.get(), e->getXPos(), e->getYPos());
                     if (auto pE = dynamic_cast<PEnemy*>(e->getRaw())) {
                         pE->poison();
                         handlePEnemyPoison(pE);
@@ -459,6 +766,7 @@ void GameController::checkForHealthPacks()
             float newHealth = p->getHealth() + (*it)->getHealAmount();
             if (newHealth > 100.0f) newHealth = 100.0f;
             p->setHealth(newHealth);
+            model->invalidatePoi((*it)->getXPos(), (*it)->getYPos());
             hpList.erase(it);
             emit model->modelUpdated();
             break;
@@ -490,6 +798,8 @@ void GameController::checkForPortal()
                     emit model->gameOver();
                     return;
                 }
+                // Autoplay carries on towards the last level, and a cross-level route with its next leg
+                bool resumeAutoPlay = autoPlayActive;
                 stopAutoPlay();
                 commandMoveTimer->stop();
                 QPoint portalCoord(portal->getXPos(), portal->getYPos());
@@ -501,8 +811,15 @@ void GameController::checkForPortal()
                 gameStateManager.newGame(model, levelCache);
                 //gameStateManager.newGame(model, levelCache);
                 model->getProtagonist()->setPos(targetX, targetY);
+                startPoiDistances();
 
                 emit model->modelUpdated();
+                // After the move that got us here has finished unwinding
+                if (resumeAutoPlay) {
+                    QTimer::singleShot(0, this, &GameController::startAutoPlay);
+                } else if (!crossLevelLegs.empty()) {
+                    QTimer::singleShot(0, this, [this]() { continueCrossLevelRoute(); });
+                }
                 break;
             }
         }
@@ -539,18 +856,90 @@ void GameController::onTileSelected(int x, int y)
 {
     stopAutoPlay();
     commandMoveTimer->stop();
+    crossLevelLegs.clear();
     moveProtagonistDirectlyToTile(x,y);
 }
 
-void GameController::moveProtagonistDirectlyToTile(int x, int y)
+void GameController::onTileHovered(int x, int y)
+{
+    previewX = x;
+    previewY = y;
+    previewRestTimer->stop();
+    if (x < 0) {
+        planningService->cancel(PathPlanningService::PreviewChannel);
+        graphicView->clearPathPreview();
+        return;
+    }
+    startPathPreview(false);
+    previewRestTimer->start();
+}
+
+void GameController::startPathPreview(bool refined)
 {
     auto *p = model->getProtagonist();
-    std::vector<int> path = computeDirectPath(p->getXPos(), p->getYPos(), x, y, true);
-    if (!path.empty()) {
-        startCommandPathMovement(path);
-    } else {
-        qDebug() << "No path found to the selected tile.";
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    if (!grid || !p || !grid->inBounds(previewX, previewY)) return;
+
+    int start = grid->index(p->getXPos(), p->getYPos());
+    int goal = grid->index(previewX, previewY);
+    if (start == goal) {
+        planningService->cancel(PathPlanningService::PreviewChannel);
+        graphicView->clearPathPreview();
+        return;
     }
+
+    // Same blockers and search as a click on this tile, so the rested preview is the path a click walks
+    uint8_t mask = model->getBlockerMask(true);
+    SearchPolicy policy = model->getSearchPolicy(GameModel::QueryKind::Command);
+    SearchMode mode = policy.modeFor(grid->hasUniformCost() ? SearchMode::JumpPoint : SearchMode::Bidirectional);
+    float epsilon = policy.epsilon;
+    if (!refined) {
+        mode = SearchMode::Weighted;
+        epsilon = std::max(epsilon, kPreviewEpsilon);
+    }
+    std::shared_ptr<const HierarchicalGraph> hierarchy = model->getHierarchy();
+
+    // Everything, the reachability check included, runs on a worker: sweeping the cursor
+    // across a big map only ever submits and cancels
+    planningService->submit<PathPreview>(PathPlanningService::PreviewChannel, grid,
+        [start, goal, mask, mode, epsilon, refined, hierarchy](SearchGrid &worker) {
+            PathPreview preview;
+            if (!worker.canReach(start, goal, mask)) return preview;
+            if (!refined && hierarchy && !worker.getPathDatabase() && hierarchy->isLongRange(worker, start, goal)) {
+                preview.waypoints = hierarchy->findWaypoints(worker, start, goal, mask);
+            } else {
+                preview.path = worker.findPath(start, goal, mask, mode, epsilon);
+            }
+            return preview;
+        },
+        [this, grid, start, refined](PathPreview preview) {
+            auto *p = model->getProtagonist();
+            if (model->getSharedSearchGrid() != grid) return;
+            if (grid->index(p->getXPos(), p->getYPos()) != start) {
+                // The protagonist moved while we searched: drop the old path and ask again once it
+                // stands still (or on the next hover), not on every step
+                graphicView->clearPathPreview();
+                previewRestTimer->start();
+                return;
+            }
+
+            std::vector<QPoint> tiles{QPoint(grid->xOf(start), grid->yOf(start))};
+            if (!preview.waypoints.empty()) {
+                for (int cell : preview.waypoints) tiles.emplace_back(grid->xOf(cell), grid->yOf(cell));
+            } else {
+                for (int d : preview.path) {
+                    tiles.emplace_back(tiles.back().x() + SearchGrid::dirDx[d], tiles.back().y() + SearchGrid::dirDy[d]);
+                }
+            }
+            graphicView->showPathPreview(tiles, !refined || !preview.waypoints.empty());
+        });
+}
+
+void GameController::moveProtagonistDirectlyToTile(int x, int y)
+{
+    startRouteTo(x, y, true, []() {
+        qDebug() << "No path found to the selected tile.";
+    });
 }
 
 void GameController::toggleOverlay()
@@ -560,66 +949,238 @@ void GameController::toggleOverlay()
     graphicView->setOverlayVisible(!visible);
 }
 
-std::vector<int> GameController::computeDirectPath(int startX, int startY, int endX, int endY, bool avoidPortalIfEnemies)
+QString GameController::describeQuery(const SearchGrid::QueryStats &stats)
 {
-    std::vector<Node> nodes;
-    const auto &tiles = model->getTiles();
-    nodes.reserve(tiles.size());
-    int cols = model->getCols();
-    int rows = model->getRows();
-
-    bool enemiesAlive = false;
-    for (auto &e : model->getEnemies()) {
-        if (!e->isDefeated()) {
-            enemiesAlive = true;
-            break;
-        }
+    static const char *modeNames[] = {"A*", "jump point", "bidirectional", "weighted A*", "focal"};
+    QString mode = modeNames[static_cast<int>(stats.mode)];
+    if (stats.fromDatabase) {
+        return QString("Last route: path database lookup, %1 steps costing %2, %3 ms")
+            .arg(stats.steps).arg(stats.cost, 0, 'f', 3).arg(stats.micros / 1000.0, 0, 'f', 3);
     }
+    if (stats.mode == SearchMode::Weighted || stats.mode == SearchMode::Focal) {
+        mode += QString(" (epsilon %1)").arg(stats.epsilon, 0, 'f', 2);
+    }
+    return QString("Last route: %1, %2 cells expanded%3, %4 steps costing %5, %6 ms")
+        .arg(mode).arg(stats.expanded).arg(QString(stats.cached ? " (cached)" : "")).arg(stats.steps)
+        .arg(stats.cost, 0, 'f', 3).arg(stats.micros / 1000.0, 0, 'f', 3);
+}
 
-    for (auto &tw : tiles) {
-        Node n(tw->getXPos(), tw->getYPos(), tw->getValue());
-        n.f = n.g = n.h = 0.0f;
-        n.visited = n.closed = false;
-        n.prev = nullptr;
-        nodes.push_back(n);
+void GameController::startRouteTo(int x, int y, bool avoidPortalIfEnemies, std::function<void()> onNoPath)
+{
+    auto *p = model->getProtagonist();
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    cancelAnytimeRoute();
+    commandWaypoints.clear();
+    commandWaypointIndex = 0;
+    commandAvoidPortal = avoidPortalIfEnemies;
+
+    if (!grid || !grid->inBounds(x, y)) {
+        planningService->cancel(PathPlanningService::CommandChannel);
+        onNoPath();
+        return;
     }
 
-    if (endX < 0 || endX >= cols || endY < 0 || endY >= rows) {
-        return {};
+    int start = grid->index(p->getXPos(), p->getYPos());
+    int goal = grid->index(x, y);
+    uint8_t mask = model->getBlockerMask(avoidPortalIfEnemies);
+    // Walls alone are an O(1) check; the blocked regions are labelled on the worker below
+    if (!grid->canReach(start, goal, 0)) {
+        planningService->cancel(PathPlanningService::CommandChannel);
+        onNoPath();
+        return;
     }
+    if (anytimeBudgetUs > 0) {
+        planningService->cancel(PathPlanningService::CommandChannel);
+        startAnytimeRoute(start, goal, mask, onNoPath);
+        return;
+    }
+    // Weighted levels get the two-frontier search: it stops as soon as the frontiers meet
+    // and reports an unreachable goal as soon as either side runs dry
+    SearchPolicy policy = model->getSearchPolicy(GameModel::QueryKind::Command);
+    SearchMode mode = policy.modeFor(grid->hasUniformCost() ? SearchMode::JumpPoint : SearchMode::Bidirectional);
+    std::shared_ptr<const HierarchicalGraph> hierarchy = model->getHierarchy();
+    uint64_t epoch = model->getBlockerEpoch();
+
+    // Searched on a worker so long queries never freeze the window; a newer click or goto cancels this one
+    planningService->submit<PlannedRoute>(PathPlanningService::CommandChannel, grid,
+        [start, goal, mask, mode, epsilon = policy.epsilon, hierarchy](SearchGrid &worker) {
+            PlannedRoute route;
+            if (!worker.canReach(start, goal, mask)) return route;
+            // A path database answers any distance without searching, so HPA* is only needed without one
+            if (hierarchy && !worker.getPathDatabase() && hierarchy->isLongRange(worker, start, goal)) {
+                // Long queries are answered on the abstract graph; legs are refined as we walk
+                route.waypoints = hierarchy->findWaypoints(worker, start, goal, mask);
+            } else {
+                route.path = worker.findPath(start, goal, mask, mode, epsilon);
+                route.stats = worker.getLastQuery();
+                route.searched = true;
+            }
+            return route;
+        },
+        [this, grid, start, epoch, onNoPath](PlannedRoute route) {
+            auto *p = model->getProtagonist();
+            // A level change or a manual move while we searched supersedes this request
+            if (model->getSharedSearchGrid() != grid || grid->index(p->getXPos(), p->getYPos()) != start) return;
+            if (route.searched) lastCommandQuery = route.stats;
+
+            if (!route.waypoints.empty()) {
+                commandWaypoints = std::move(route.waypoints);
+                commandWaypointIndex = 0;
+                refineNextCommandLeg(onNoPath);
+                return;
+            }
+            if (route.path.empty()) {
+                onNoPath();
+                return;
+            }
+            startCommandPathMovement(route.path);
+            // Blockers that changed while the worker searched get repaired on the first step
+            commandBlockerEpoch = epoch;
+        });
+}
 
-    Node &startNode = nodes[startY*cols + startX];
-    Node &endNode   = nodes[endY*cols + endX];
+void GameController::startPoiDistances()
+{
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    auto *p = model->getProtagonist();
+    if (!grid || !p || model->getPoiDistances()) return;
 
-    auto costFunc = [this, enemiesAlive, avoidPortalIfEnemies](const Node &a, const Node &b) {
-        for (auto &e : model->getEnemies()) {
-            if (!e->isDefeated() && e->getXPos() == b.getXPos() && e->getYPos() == b.getYPos()) {
-                return std::numeric_limits<float>::infinity();
-            }
-        }
-        if (enemiesAlive && avoidPortalIfEnemies) {
-            for (auto &port : model->getPortals()) {
-                if (port->getXPos()==b.getXPos() && port->getYPos()==b.getYPos()) {
-                    return std::numeric_limits<float>::infinity();
+    using Poi = PoiDistanceMatrix::Poi;
+    using Kind = PoiDistanceMatrix::Kind;
+    std::vector<Poi> pois;
+    auto add = [&](Kind kind, int x, int y) {
+        if (grid->inBounds(x, y)) pois.push_back({kind, grid->index(x, y)});
+    };
+    add(Kind::Start, p->getXPos(), p->getYPos());
+    for (auto &e : model->getEnemies()) {
+        if (!e->isDefeated()) add(Kind::Enemy, e->getXPos(), e->getYPos());
+    }
+    for (auto &hp : model->getHealthPacks()) add(Kind::HealthPack, hp->getXPos(), hp->getYPos());
+    for (auto &portal : model->getPortals()) add(Kind::Portal, portal->getXPos(), portal->getYPos());
+
+    auto matrix = std::make_shared<PoiDistanceMatrix>(std::move(pois), model->getBlockerMask(true));
+    model->setPoiDistances(matrix);
+
+    // One flood per row on the background pool; every finished row is usable right away
+    planningService->submit<bool>(PathPlanningService::BackgroundChannel, grid,
+        [this, matrix](SearchGrid &worker) {
+            matrix->compute(worker, [this, &worker, matrix](int done, int total) {
+                if (worker.isCancelled()) return;
+                QMetaObject::invokeMethod(model, [this, matrix, done, total]() {
+                    // A newer level dropped this matrix
+                    if (model->getPoiDistances() == matrix) emit model->poiDistancesProgress(done, total);
+                }, Qt::QueuedConnection);
+            });
+            return matrix->isComplete();
+        },
+        [](bool) {});
+}
+
+void GameController::refineNextCommandLeg(std::function<void()> onNoPath)
+{
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    auto *p = model->getProtagonist();
+    int start = grid->index(p->getXPos(), p->getYPos());
+    std::vector<int> waypoints(commandWaypoints.begin() + commandWaypointIndex, commandWaypoints.end());
+    uint8_t mask = model->getBlockerMask(commandAvoidPortal);
+    SearchPolicy policy = model->getSearchPolicy(GameModel::QueryKind::Command);
+    SearchMode exact = grid->hasUniformCost() ? SearchMode::JumpPoint : SearchMode::Bidirectional;
+    uint64_t epoch = model->getBlockerEpoch();
+
+    planningService->submit<RefinedLeg>(PathPlanningService::CommandChannel, grid,
+        [start, waypoints, mask, policy, exact](SearchGrid &worker) {
+            RefinedLeg leg;
+            auto search = [&](int goal, SearchMode mode) {
+                // Sealed-off goals are answered from the region labels instead of exhausting the start's region
+                if (!worker.canReach(start, goal, mask)) return std::vector<int>();
+                std::vector<int> path = worker.findPath(start, goal, mask, policy.modeFor(mode), policy.epsilon);
+                leg.stats = worker.getLastQuery();
+                leg.searched = true;
+                return path;
+            };
+            while (leg.waypointsUsed < waypoints.size()) {
+                int target = waypoints[leg.waypointsUsed++];
+                leg.path = search(target, SearchMode::JumpPoint);
+                if (!leg.path.empty()) return leg;
+                if (target != start) {
+                    // Something now blocks this leg: give up on the abstract route and search to the goal directly
+                    leg.abandoned = true;
+                    leg.path = search(waypoints.back(), exact);
+                    return leg;
                 }
             }
-        }
+            leg.abandoned = true;
+            return leg;
+        },
+        [this, grid, start, epoch, onNoPath](RefinedLeg leg) {
+            auto *p = model->getProtagonist();
+            if (model->getSharedSearchGrid() != grid || grid->index(p->getXPos(), p->getYPos()) != start) return;
+            if (leg.searched) lastCommandQuery = leg.stats;
+
+            if (leg.abandoned) {
+                commandWaypoints.clear();
+                commandWaypointIndex = 0;
+            } else {
+                commandWaypointIndex += static_cast<int>(leg.waypointsUsed);
+            }
+            if (leg.path.empty()) {
+                onNoPath();
+                return;
+            }
+            startCommandPathMovement(leg.path);
+            commandBlockerEpoch = epoch;
+        });
+}
 
-        float val = b.getValue();
-        return 1.0f/(val+1.0f)*0.1f;
-    };
+void GameController::startAnytimeRoute(int start, int goal, uint8_t mask, std::function<void()> onNoPath)
+{
+    anytimeSearch.start(model->getSharedSearchGrid(), start, goal, mask);
+    anytimeTrail.assign(1, start);
+    anytimeShownBest = -1;
+    anytimeNoPath = std::move(onNoPath);
 
-    auto heuristicFunc = [](const Node &a, const Node &b) {
-        return std::sqrt((a.getXPos()-b.getXPos())*(a.getXPos()-b.getXPos())
-                         + (a.getYPos()-b.getYPos())*(a.getYPos()-b.getYPos()));
-    };
+    // The first slice runs now so the first step can be taken on the next move tick
+    commandPath.clear();
+    commandPathIndex = 0;
+    commandMoveTimer->start();
+    anytimeTimer->start();
+    runAnytimeSlice();
+}
 
-    std::function<bool(const Node&, const Node&)> nodeComparator = [](const Node &A, const Node &B){
-        return A.f > B.f;
-    };
+void GameController::cancelAnytimeRoute()
+{
+    anytimeTimer->stop();
+    anytimeSearch.reset();
+    anytimeTrail.clear();
+    anytimeNoPath = nullptr;
+}
+
+void GameController::runAnytimeSlice()
+{
+    auto *p = model->getProtagonist();
+    SearchGrid *grid = model->getSearchGrid();
+    // Movement stopped, the level changed, or the protagonist was moved off the route by hand
+    if (!anytimeSearch.isRunning() || !commandMoveTimer->isActive() || anytimeSearch.getGrid() != grid
+        || anytimeTrail.empty() || grid->index(p->getXPos(), p->getYPos()) != anytimeTrail.back()) {
+        cancelAnytimeRoute();
+        return;
+    }
+
+    AnytimeSearch::Status status = anytimeSearch.run(std::chrono::microseconds(anytimeBudgetUs));
+    if (status == AnytimeSearch::Status::NoPath) {
+        std::function<void()> onNoPath = std::move(anytimeNoPath);
+        cancelAnytimeRoute();
+        commandMoveTimer->stop();
+        if (onNoPath) onNoPath();
+        return;
+    }
 
-    PathFinder<Node, Node> pathfinder(nodes, &startNode, &endNode, nodeComparator, (unsigned int)cols, costFunc, heuristicFunc, 1.0f);
-    return pathfinder.A_star();
+    // Only hand over a new path when the best cell moved; the replanner restarts with each one
+    if (anytimeSearch.getBestCell() != anytimeShownBest) {
+        anytimeShownBest = anytimeSearch.getBestCell();
+        startCommandPathMovement(anytimeSearch.continuationFrom(anytimeTrail));
+    }
+    if (status == AnytimeSearch::Status::Found) cancelAnytimeRoute();
 }
 
 // New method to start the animated command-based movement
@@ -627,14 +1188,108 @@ void GameController::startCommandPathMovement(const std::vector<int> &path)
 {
     commandPath = path;
     commandPathIndex = 0;
-    commandMoveTimer->start();
+
+    // Remember where the path ends so it can be repaired if blockers change on the way
+    auto *p = model->getProtagonist();
+    int x = p->getXPos();
+    int y = p->getYPos();
+    for (int d : path) {
+        x += SearchGrid::dirDx[d];
+        y += SearchGrid::dirDy[d];
+    }
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    int start = grid->index(p->getXPos(), p->getYPos());
+    commandGoal = grid->index(x, y);
+    commandBlockerEpoch = model->getBlockerEpoch();
+
+    // The next leg to the same goal keeps the tree; a repair of the previous path may still hold the old one
+    uint8_t mask = model->getBlockerMask(commandAvoidPortal);
+    if (!commandReplanner || commandReplanner->levelId != grid->getLevelId() || commandReplanner->goal != commandGoal
+        || commandReplanner->mask != mask) {
+        auto replanner = std::make_shared<CommandReplanner>();
+        replanner->levelId = grid->getLevelId();
+        replanner->goal = commandGoal;
+        replanner->mask = mask;
+        commandReplanner = replanner;
+
+        // Plan the tree now, so the first repair only patches it instead of searching the whole way back
+        uint64_t epoch = commandBlockerEpoch;
+        int goal = commandGoal;
+        if (start != goal) {
+            planningService->submit<bool>(PathPlanningService::CommandSeedChannel, grid,
+                [replanner, start, goal, mask, epoch](SearchGrid &worker) {
+                    if (worker.isCancelled()) return false;
+                    std::lock_guard<std::mutex> guard(replanner->lock);
+                    // A repair got there first
+                    if (replanner->epoch.load() != CommandReplanner::unplanned) return false;
+                    replanner->planner.replan(worker, start, goal, mask, nullptr);
+                    replanner->epoch.store(epoch);
+                    return true;
+                },
+                [](bool) {});
+        }
+    }
+
+    // Anytime routes swap paths mid-walk; restarting the timer would keep postponing the next step
+    if (!commandMoveTimer->isActive()) commandMoveTimer->start();
+}
+
+void GameController::repairCommandPath()
+{
+    std::shared_ptr<SearchGrid> grid = model->getSharedSearchGrid();
+    auto *p = model->getProtagonist();
+    std::shared_ptr<CommandReplanner> replanner = commandReplanner;
+    // The tree may be older than this path (an earlier leg to the same goal planned it); patch it from there
+    std::vector<int> changes;
+    uint64_t since = replanner->epoch.load();
+    bool known = since != CommandReplanner::unplanned && model->getBlockerChangesSince(since, changes);
+    uint64_t epoch = model->getBlockerEpoch();
+    commandBlockerEpoch = epoch;
+
+    int start = grid->index(p->getXPos(), p->getYPos());
+    int goal = commandGoal;
+    uint8_t mask = replanner->mask;
+    planningService->submit<std::vector<int>>(PathPlanningService::CommandChannel, grid,
+        [replanner, start, goal, mask, known, since, epoch, changes](SearchGrid &worker) {
+            if (worker.isCancelled()) return std::vector<int>();
+            std::lock_guard<std::mutex> guard(replanner->lock);
+            // Changes since an older epoch cover a newer tree too; an older or unplanned one starts over
+            uint64_t tree = replanner->epoch.load();
+            bool patch = known && tree != CommandReplanner::unplanned && tree >= since;
+            std::vector<int> path = replanner->planner.replan(worker, start, goal, mask, patch ? &changes : nullptr);
+            replanner->epoch.store(epoch);
+            return path;
+        },
+        [this, grid, start](std::vector<int> path) {
+            auto *p = model->getProtagonist();
+            if (model->getSharedSearchGrid() != grid) return;
+            // Moved by hand meanwhile: the rest of the old path no longer starts here either
+            if (grid->index(p->getXPos(), p->getYPos()) != start) path.clear();
+            commandPath = std::move(path);
+            commandPathIndex = 0;
+        });
 }
 
 void GameController::handleCommandMoveStep()
 {
+    // A repair or the next leg is still being searched on a worker: wait for it
+    if (planningService->isPending(PathPlanningService::CommandChannel)) return;
+
+    if (commandPathIndex < (int)commandPath.size() && model->getBlockerEpoch() != commandBlockerEpoch) {
+        // An enemy teleported or was defeated mid-walk: repair the rest of the path incrementally
+        repairCommandPath();
+        return;
+    }
+
     if (commandPathIndex >= (int)commandPath.size()) {
-        // Done with movement
-        commandMoveTimer->stop();
+        // Partial path walked: wait for the next anytime slice to extend it
+        if (anytimeSearch.isRunning()) return;
+        // Leg finished: refine the next one of a hierarchical route, or stop
+        if (commandWaypointIndex >= (int)commandWaypoints.size()) {
+            commandMoveTimer->stop();
+            return;
+        }
+        refineNextCommandLeg([this]() { commandMoveTimer->stop(); });
         return;
     }
 
@@ -654,42 +1309,12 @@ void GameController::handleCommandMoveStep()
     moveProtagonist(dx,dy);
 
     auto *p = model->getProtagonist();
+    if (anytimeSearch.isRunning()) {
+        int cell = model->getSearchGrid()->index(p->getXPos(), p->getYPos());
+        if (cell != anytimeTrail.back()) anytimeTrail.push_back(cell);
+    }
     if (p->getHealth() <= 0 || p->getEnergy() <= 0) {
         // Movement ended due to death
         commandMoveTimer->stop();
     }
 }
-
-EnemyWrapper* GameController::findNearestUndefeatedEnemy()
-{
-    EnemyWrapper* targetEnemy = nullptr;
-    float minDist = std::numeric_limits<float>::max();
-    auto *p = model->getProtagonist();
-    for (auto &e : model->getEnemies()) {
-        if (!e->isDefeated()) {
-            float dist = std::sqrt((e->getXPos() - p->getXPos())*(e->getXPos()-p->getXPos())
-                                   + (e->getYPos() - p->getYPos())*(e->getYPos()-p->getYPos()));
-            if (dist < minDist) {
-                minDist = dist;
-                targetEnemy = e.get();
-            }
-        }
-    }
-    return targetEnemy;
-}
-
-HealthPack* GameController::findNearestHealthPack()
-{
-    HealthPack* nearestHP = nullptr;
-    float minDist = std::numeric_limits<float>::max();
-    auto *p = model->getProtagonist();
-    for (auto &hp : model->getHealthPacks()) {
-        float dist = std::sqrt((hp->getXPos()-p->getXPos())*(hp->getXPos()-p->getXPos())
-                               + (hp->getYPos()-p->getYPos())*(hp->getYPos()-p->getYPos()));
-        if (dist < minDist) {
-            minDist = dist;
-            nearestHP = hp.get();
-        }
-    }
-    return nearestHP;
-}
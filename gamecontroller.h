@@ -11,16 +11,22 @@
 #include <QMap>
 #include <memory> // for shared_ptr
 #include <functional>
+#include <mutex>
+#include <atomic>
+#include <limits>
 
 #include "gamemodel.h"
 #include "gameview.h"
 #include "textgameview.h"
-#include "pathfinder_class.h"
-#include "node.h"
 #include "commandparser.h"
 #include "autoplaystrategy.h"
 #include "defaultautoplaystrategy.h"
 #include "gamestatemanager.h"
+#include "distancemap.h"
+#include "dstarlite.h"
+#include "pathplanningservice.h"
+#include "anytimesearch.h"
+#include "portalgraph.h"
 
 class GameController : public QMainWindow
 {
@@ -38,6 +44,7 @@ public slots:
     void moveLeft();
     void moveRight();
     void gotoXY(int x, int y);
+    void gotoLevelXY(int level, int x, int y);
     void attackNearestEnemy();
     void takeNearestHealthPack();
     void printHelp();
@@ -53,10 +60,12 @@ private slots:
     void newGame();
     void restartGame();
     void onTileSelected(int x, int y);
+    void onTileHovered(int x, int y);
     void handleTextCommand(QString command);
 
     // New slot for command-based movement steps
     void handleCommandMoveStep();
+    void runAnytimeSlice();
 
 private:
     void setupModel();
@@ -72,16 +81,64 @@ private:
     void checkForPortal();
     void handlePEnemyPoison(PEnemy *pEnemy);
 
-    std::vector<int> computeDirectPath(int startX, int startY, int endX, int endY, bool avoidPortalIfEnemies = false);
+    // One line of "path stats" for a click/goto search
+    static QString describeQuery(const SearchGrid::QueryStats &stats);
 
     // Updated: Instead of instantly moving along the path, we store it and animate.
     void startCommandPathMovement(const std::vector<int> &path);
+    void repairCommandPath();
 
     // For mouse click movement (direct path movement)
     void moveProtagonistDirectlyToTile(int x, int y);
 
-    EnemyWrapper* findNearestUndefeatedEnemy();
-    HealthPack* findNearestHealthPack();
+    // Result of a command route search: a direct path, or HPA* waypoints for long routes.
+    struct PlannedRoute {
+        std::vector<int> path;
+        std::vector<int> waypoints;
+        SearchGrid::QueryStats stats; // of the direct search, if one ran
+        bool searched = false;
+    };
+
+    // Plans a route to (x,y) on the planning service and starts walking it when the result
+    // arrives; long routes go through the HPA* graph. onNoPath runs if there is no route.
+    void startRouteTo(int x, int y, bool avoidPortalIfEnemies, std::function<void()> onNoPath);
+
+    // Next leg of a hierarchical route, searched on the command channel from the next waypoint
+    // that can be reached; falls back to a direct search to the goal when a leg is blocked.
+    struct RefinedLeg {
+        std::vector<int> path;
+        size_t waypointsUsed = 0;
+        bool abandoned = false; // the waypoints are done with (blocked, or none left)
+        SearchGrid::QueryStats stats;
+        bool searched = false;
+    };
+    void refineNextCommandLeg(std::function<void()> onNoPath);
+    // Anytime variant of startRouteTo: walks partial paths while later slices refine them.
+    void startAnytimeRoute(int start, int goal, uint8_t mask, std::function<void()> onNoPath);
+    void cancelAnytimeRoute();
+
+    // Hover preview on its own channel: every new tile supersedes the previous query. The
+    // quick pass is an approximation (weighted A* or HPA* waypoints); once the cursor rests
+    // on a tile, and the protagonist is not walking, it is replaced by the path a click would take.
+    struct PathPreview {
+        std::vector<int> path;
+        std::vector<int> waypoints;
+    };
+    void startPathPreview(bool refined);
+
+    // Cross-level routing: the portal graph covers every cached level, generating levels up to
+    // upToLevel that were never visited. Legs are walked one level at a time; each portal hop
+    // continues with the next leg once the new level is set up.
+    bool refreshPortalGraph(int upToLevel);
+    bool continueCrossLevelRoute();
+    // Points autoplay at the portal that leads towards the last level
+    void aimAutoPlayExit();
+
+    // Starts filling the level's POI distance matrix on the background channel (once per level).
+    void startPoiDistances();
+
+    // Walks to the nearest of cells by path distance, found by one flood on the command channel.
+    void startNearestRoute(const std::vector<int> &cells, const QString &moving, const QString &noPath);
 
     bool autoPlayActive = false;
     bool oneShotMovement = false;
@@ -108,12 +165,52 @@ private:
     CommandParser commandParser;
 
     std::unique_ptr<AutoPlayStrategy> autoPlayStrategy;
+    PathPlanningService *planningService;
     GameStateManager gameStateManager;
 
     // New fields for command-based movement animation
     QTimer *commandMoveTimer;
     std::vector<int> commandPath;
     int commandPathIndex;
+
+    // Remaining HPA* waypoints (cell indices) of the current command route
+    std::vector<int> commandWaypoints;
+    int commandWaypointIndex;
+    bool commandAvoidPortal;
+
+    // End cell of commandPath and the blocker epoch it was planned against
+    int commandGoal;
+    uint64_t commandBlockerEpoch;
+    // D* Lite tree towards commandGoal, kept across paths to the same goal and seeded when the
+    // first one starts; seeds and repairs run on worker threads under its lock
+    struct CommandReplanner {
+        static constexpr uint64_t unplanned = std::numeric_limits<uint64_t>::max();
+        std::mutex lock;
+        DStarLite planner;
+        uint64_t levelId = 0;
+        int goal = -1;
+        uint8_t mask = 0;
+        std::atomic<uint64_t> epoch{unplanned}; // blocker epoch the tree was last planned against
+    };
+    std::shared_ptr<CommandReplanner> commandReplanner;
+    SearchGrid::QueryStats lastCommandQuery;
+
+    // Anytime click/goto search: microseconds per slice, 0 = off (plan on the worker pool)
+    int anytimeBudgetUs;
+    QTimer *anytimeTimer;
+    AnytimeSearch anytimeSearch;
+    std::vector<int> anytimeTrail; // cells walked since the search's start cell
+    int anytimeShownBest;          // best cell of the path handed to the move timer
+    std::function<void()> anytimeNoPath;
+
+    PortalGraph portalGraph;
+    QMap<int, std::shared_ptr<GameStateManager::CachedLevel>> portalGraphLevels; // what each graph level was built from
+    std::vector<PortalGraph::Leg> crossLevelLegs;
+    size_t crossLevelLegIndex = 0;
+
+    QTimer *previewRestTimer;
+    int previewX;
+    int previewY;
 };
 
 #endif // GAMECONTROLLER_H
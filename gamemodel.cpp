@@ -1,8 +1,15 @@
 #include "gamemodel.h"
+#include <algorithm>
 #include <limits>
 
+namespace {
+// What handlePEnemyPoison deals to a protagonist within reach
+constexpr float kPoisonDamage = 5.0f;
+}
+
 GameModel::GameModel(QObject *parent)
-    : QObject(parent), rows(0), cols(0), currentLevel(0)
+    : QObject(parent), rows(0), cols(0), openListKind(OpenListKind::BucketQueue), currentLevel(0), exitPortalCell(-1), livingEnemies(0),
+      blockerEpoch(0), journalBaseEpoch(0), dangerWeight(0.002f)
 {
     // Level files here
     levelFiles = {":/images/level1.png", ":/images/level2.png", ":/images/level3.png"};
@@ -20,11 +27,54 @@ void GameModel::setTiles(std::vector<std::unique_ptr<TileWrapper>> t, int r, int
     tiles = std::move(t);
     rows = r;
     cols = c;
+    searchGrid = std::make_shared<SearchGrid>(tiles, rows, cols);
+    searchGrid->setOpenListKind(openListKind);
+    hierarchy.reset();
+    landmarks.reset();
+    regions.reset();
+    pathDatabase.reset();
+    poiDistances.reset();
+    rebuildBlockers();
     emit modelUpdated();
 }
 
+void GameModel::setLandmarks(std::shared_ptr<const LandmarkTable> l) {
+    landmarks = std::move(l);
+    if (searchGrid) searchGrid->setLandmarks(landmarks);
+}
+
+void GameModel::setRegions(std::shared_ptr<const RegionLabels> r) {
+    regions = std::move(r);
+    if (searchGrid) searchGrid->setRegions(regions);
+}
+
+void GameModel::setPathDatabase(std::shared_ptr<const CompressedPathDatabase> db) {
+    pathDatabase = std::move(db);
+    if (searchGrid) searchGrid->setPathDatabase(pathDatabase);
+}
+
+Portal* GameModel::getExitPortal() const {
+    if (portals.empty()) return nullptr;
+    // The portal leading on to the next level, if there is one
+    Portal *portal = portals.front().get();
+    for (auto &p : portals) {
+        if (exitPortalCell >= 0) {
+            if (p->getYPos() * cols + p->getXPos() == exitPortalCell) return p.get();
+        } else if (p->getTargetLevel() == currentLevel + 1) {
+            portal = p.get();
+        }
+    }
+    return portal;
+}
+
+void GameModel::setOpenListKind(OpenListKind kind) {
+    openListKind = kind;
+    if (searchGrid) searchGrid->setOpenListKind(kind);
+}
+
 void GameModel::setEnemies(std::vector<std::unique_ptr<EnemyWrapper>> e) {
     enemies = std::move(e);
+    rebuildBlockers();
     emit modelUpdated();
 }
 
@@ -35,6 +85,8 @@ void GameModel::setHealthPacks(std::vector<std::unique_ptr<HealthPack>> hp) {
 
 void GameModel::setPortals(std::vector<std::unique_ptr<Portal>> p) {
     portals = std::move(p);
+    exitPortalCell = -1;
+    rebuildBlockers();
     emit modelUpdated();
 }
 
@@ -57,3 +109,174 @@ bool GameModel::isTilePassable(int x, int y) const
     // Otherwise, it's passable
     return true;
 }
+
+uint8_t GameModel::getBlockerMask(bool avoidPortals) const
+{
+    uint8_t mask = SearchGrid::BlockEnemy;
+    if (avoidPortals && livingEnemies > 0) {
+        mask |= SearchGrid::BlockPortal;
+    }
+    return mask;
+}
+
+uint8_t GameModel::getAutoPlayMask() const
+{
+    uint8_t mask = getBlockerMask(true);
+    if (dangerWeight > 0.0f) mask |= SearchGrid::AvoidDanger;
+    return mask;
+}
+
+void GameModel::setDangerWeight(float weight)
+{
+    dangerWeight = std::max(0.0f, weight);
+    if (!searchGrid) return;
+    // Every dangerous cell changed cost
+    ++blockerEpoch;
+    journalBaseEpoch = blockerEpoch;
+    blockerJournal.clear();
+    writeDangerLayer();
+}
+
+void GameModel::updateEnemyBlocker(const EnemyWrapper *enemy, int oldX, int oldY)
+{
+    refreshEnemyCell(oldX, oldY);
+    refreshEnemyCell(enemy->getXPos(), enemy->getYPos());
+
+    // Its danger goes or moves with it; only the squares it covered before and after are touched
+    if (searchGrid) {
+        std::vector<InfluenceMap::Box> touched;
+        auto it = dangerSources.find(enemy);
+        if (it != dangerSources.end()) {
+            for (auto &s : it->second) touched.push_back(influence.add(s, -1.0f));
+            dangerSources.erase(it);
+        }
+        std::vector<InfluenceMap::Source> own = dangerSourcesOf(*enemy);
+        for (auto &s : own) touched.push_back(influence.add(s));
+        if (!own.empty()) dangerSources[enemy] = std::move(own);
+        for (auto &box : touched) writeDanger(box);
+    }
+
+    // The enemy no longer stands where its distances were measured
+    if (enemy->isDefeated()) invalidatePoi(enemy->getXPos(), enemy->getYPos());
+    if (oldX != enemy->getXPos() || oldY != enemy->getYPos()) invalidatePoi(oldX, oldY);
+
+    livingEnemies = 0;
+    for (auto &e : enemies) {
+        if (!e->isDefeated()) ++livingEnemies;
+    }
+}
+
+void GameModel::invalidatePoi(int x, int y)
+{
+    if (!poiDistances || !searchGrid || !searchGrid->inBounds(x, y)) return;
+    poiDistances->invalidateCell(searchGrid->index(x, y));
+}
+
+void GameModel::refreshEnemyCell(int x, int y)
+{
+    if (!searchGrid || !searchGrid->inBounds(x, y)) return;
+
+    // Another living enemy may share the cell, so re-derive the bit instead of clearing it
+    bool occupied = false;
+    for (auto &e : enemies) {
+        if (!e->isDefeated() && e->getXPos() == x && e->getYPos() == y) {
+            occupied = true;
+            break;
+        }
+    }
+    int idx = searchGrid->index(x, y);
+    if (searchGrid->isBlocked(idx, SearchGrid::BlockEnemy) == occupied) return;
+    searchGrid->setBlocker(idx, SearchGrid::BlockEnemy, occupied);
+    journalCell(idx);
+}
+
+void GameModel::journalCell(int idx)
+{
+    if (blockerJournal.size() >= maxJournalSize) {
+        // Readers that fell this far behind just plan from scratch
+        journalBaseEpoch = blockerEpoch;
+        blockerJournal.clear();
+    }
+    blockerJournal.push_back(idx);
+    ++blockerEpoch;
+}
+
+bool GameModel::getBlockerChangesSince(uint64_t epoch, std::vector<int> &cells) const
+{
+    cells.clear();
+    if (epoch < journalBaseEpoch || epoch > blockerEpoch) return false;
+    cells.assign(blockerJournal.begin() + static_cast<std::ptrdiff_t>(epoch - journalBaseEpoch), blockerJournal.end());
+    return true;
+}
+
+void GameModel::rebuildBlockers()
+{
+    // Every cell may have changed, so earlier journal entries are no use to anyone
+    ++blockerEpoch;
+    journalBaseEpoch = blockerEpoch;
+    blockerJournal.clear();
+
+    livingEnemies = 0;
+    for (auto &e : enemies) {
+        if (!e->isDefeated()) ++livingEnemies;
+    }
+
+    if (!searchGrid) return;
+    searchGrid->clearBlockers();
+    for (auto &e : enemies) {
+        if (!e->isDefeated() && searchGrid->inBounds(e->getXPos(), e->getYPos())) {
+            searchGrid->setBlocker(searchGrid->index(e->getXPos(), e->getYPos()), SearchGrid::BlockEnemy, true);
+        }
+    }
+    for (auto &port : portals) {
+        if (searchGrid->inBounds(port->getXPos(), port->getYPos())) {
+            searchGrid->setBlocker(searchGrid->index(port->getXPos(), port->getYPos()), SearchGrid::BlockPortal, true);
+        }
+    }
+
+    dangerSources.clear();
+    std::vector<InfluenceMap::Source> sources;
+    for (auto &e : enemies) {
+        std::vector<InfluenceMap::Source> own = dangerSourcesOf(*e);
+        if (own.empty()) continue;
+        sources.insert(sources.end(), own.begin(), own.end());
+        dangerSources[e.get()] = std::move(own);
+    }
+    influence.rebuild(rows, cols, sources);
+    writeDangerLayer();
+}
+
+std::vector<InfluenceMap::Source> GameModel::dangerSourcesOf(const EnemyWrapper &enemy) const
+{
+    std::vector<InfluenceMap::Source> sources;
+    int x = enemy.getXPos();
+    int y = enemy.getYPos();
+    if (enemy.isDefeated() || x < 0 || x >= cols || y < 0 || y >= rows) return sources;
+
+    // A fight costs its strength; the cells around it are where one starts
+    sources.push_back({x, y, 1, enemy.getStrength()});
+    // Poison reaches as far as handlePEnemyPoison does once it is defeated
+    if (auto *pEnemy = dynamic_cast<const PEnemyWrapper*>(&enemy)) {
+        sources.push_back({x, y, static_cast<int>(pEnemy->getPoisonLevel() / 10), kPoisonDamage});
+    }
+    return sources;
+}
+
+void GameModel::writeDangerLayer()
+{
+    std::vector<float> extra(static_cast<size_t>(searchGrid->size()), 0.0f);
+    if (influence.getRows() == searchGrid->getRows() && influence.getCols() == searchGrid->getCols()) {
+        for (size_t i = 0; i < extra.size(); ++i) extra[i] = dangerWeight * influence.at(static_cast<int>(i));
+    }
+    searchGrid->setDangerLayer(extra);
+}
+
+void GameModel::writeDanger(const InfluenceMap::Box &box)
+{
+    for (int y = box.y0; y <= box.y1; ++y) {
+        for (int x = box.x0; x <= box.x1; ++x) {
+            int idx = searchGrid->index(x, y);
+            if (searchGrid->setDanger(idx, dangerWeight * influence.at(idx))) journalCell(idx);
+        }
+    }
+}
@@ -14,6 +14,14 @@
 #include "healthpack.h"
 #include "portal.h"
 #include "tile.h"
+#include "searchgrid.h"
+#include "hierarchicalgraph.h"
+#include "landmarks.h"
+#include "regionlabels.h"
+#include "compressedpathdatabase.h"
+#include "poidistancematrix.h"
+#include "influencemap.h"
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -43,7 +51,22 @@ public:
     const std::vector<std::unique_ptr<EnemyWrapper>>& getEnemies() const { return enemies; }
     const std::vector<std::unique_ptr<HealthPack>>& getHealthPacks() const { return healthPacks; }
     const std::vector<std::unique_ptr<Portal>>& getPortals() const { return portals; }
+    // Portal autoplay leaves the level through: the one set for a cross-level route, else the
+    // one leading on to the next level. Reset whenever the portals change.
+    Portal* getExitPortal() const;
+    void setExitPortal(int cell) { exitPortalCell = cell; }
     const std::vector<std::unique_ptr<TileWrapper>>& getTiles() const { return tiles; }
+    SearchGrid* getSearchGrid() const { return searchGrid.get(); }
+    // Keeps the level's grid alive for planning work still running on other threads
+    std::shared_ptr<SearchGrid> getSharedSearchGrid() const { return searchGrid; }
+    std::shared_ptr<const HierarchicalGraph> getHierarchy() const { return hierarchy; }
+    // Open list for path searches; kept across levels and applied to every new grid.
+    void setOpenListKind(OpenListKind kind);
+    OpenListKind getOpenListKind() const { return openListKind; }
+    // Speed/quality trade-off per kind of path query; kept across levels.
+    enum class QueryKind { Command, AutoPlay };
+    void setSearchPolicy(QueryKind kind, SearchPolicy policy) { searchPolicies[static_cast<int>(kind)] = policy; }
+    SearchPolicy getSearchPolicy(QueryKind kind) const { return searchPolicies[static_cast<int>(kind)]; }
 
     // Mutators
     void setProtagonist(std::unique_ptr<ProtagonistWrapper> p);
@@ -51,6 +74,14 @@ public:
     void setEnemies(std::vector<std::unique_ptr<EnemyWrapper>> e);
     void setHealthPacks(std::vector<std::unique_ptr<HealthPack>> hp);
     void setPortals(std::vector<std::unique_ptr<Portal>> p);
+    // Set after setTiles(); built by GameStateManager or reused from the level cache
+    void setHierarchy(std::shared_ptr<const HierarchicalGraph> h) { hierarchy = std::move(h); }
+    void setLandmarks(std::shared_ptr<const LandmarkTable> l);
+    std::shared_ptr<const LandmarkTable> getLandmarks() const { return landmarks; }
+    void setRegions(std::shared_ptr<const RegionLabels> r);
+    std::shared_ptr<const RegionLabels> getRegions() const { return regions; }
+    void setPathDatabase(std::shared_ptr<const CompressedPathDatabase> db);
+    std::shared_ptr<const CompressedPathDatabase> getPathDatabase() const { return pathDatabase; }
 
     void setCurrentLevel(int level) { currentLevel = level; }
     int getCurrentLevel() const { return currentLevel; }
@@ -59,10 +90,38 @@ public:
     const QVector<QString>& getLevelFiles() const { return levelFiles; }
     bool isTilePassable(int x, int y) const;
 
+    // Blocker bitmap upkeep. Call after an enemy is defeated or moves;
+    // (oldX, oldY) is where it stood before the change.
+    void updateEnemyBlocker(const EnemyWrapper *enemy, int oldX, int oldY);
+    bool hasLivingEnemies() const { return livingEnemies > 0; }
+    // Mask for SearchGrid::getStepCost(): enemies always, portals only while enemies are alive.
+    uint8_t getBlockerMask(bool avoidPortals) const;
+    // getBlockerMask(true), plus the danger layer while it is weighted in
+    uint8_t getAutoPlayMask() const;
+
+    // Danger layer: hit points at risk near enemies (strength) and within poison reach, times the
+    // weight in energy per hit point, on top of each cell's step cost. 0 turns it off.
+    void setDangerWeight(float weight);
+    float getDangerWeight() const { return dangerWeight; }
+    const InfluenceMap& getInfluence() const { return influence; }
+
+    // Blocker change journal for incremental replanning. The epoch grows with every changed cell;
+    // a full rebuild (new level or entity lists) starts a fresh journal.
+    uint64_t getBlockerEpoch() const { return blockerEpoch; }
+    // Cells whose blocker bits or danger changed after epoch; false if the journal no longer reaches back that far.
+    bool getBlockerChangesSince(uint64_t epoch, std::vector<int> &cells) const;
+
+    // Distances between the level's points of interest, filled in on a worker (see PoiDistanceMatrix).
+    void setPoiDistances(std::shared_ptr<PoiDistanceMatrix> m) { poiDistances = std::move(m); }
+    std::shared_ptr<const PoiDistanceMatrix> getPoiDistances() const { return poiDistances; }
+    // The point of interest at (x, y) is gone (picked up, defeated, moved); its distances are dropped.
+    void invalidatePoi(int x, int y);
+
 signals:
     void modelUpdated();
     void gameOver();
     void modelReset();
+    void poiDistancesProgress(int done, int total);
 
 private:
     int rows;
@@ -73,10 +132,37 @@ private:
     std::vector<std::unique_ptr<HealthPack>> healthPacks;
     std::vector<std::unique_ptr<Portal>> portals;
     std::vector<std::unique_ptr<TileWrapper>> tiles;
+    std::shared_ptr<SearchGrid> searchGrid; // rebuilt once per level in setTiles()
+    std::shared_ptr<const HierarchicalGraph> hierarchy;
+    std::shared_ptr<const LandmarkTable> landmarks; // ALT tables, handed to searchGrid
+    std::shared_ptr<const RegionLabels> regions;    // wall-separated regions, handed to searchGrid
+    std::shared_ptr<const CompressedPathDatabase> pathDatabase; // first-move table, handed to searchGrid
+    OpenListKind openListKind;
+    SearchPolicy searchPolicies[2]; // indexed by QueryKind
+    std::shared_ptr<PoiDistanceMatrix> poiDistances; // dropped with the grid
 
     int currentLevel;
+    int exitPortalCell;
+    int livingEnemies;
     QVector<QString> levelFiles; // Levels
 
+    static constexpr size_t maxJournalSize = 1024;
+    uint64_t blockerEpoch;
+    uint64_t journalBaseEpoch; // epoch just before blockerJournal[0]
+    std::vector<int> blockerJournal;
+
+    InfluenceMap influence;
+    float dangerWeight;
+    // What each living enemy added to influence, so it can be taken out again when it dies or moves
+    std::unordered_map<const EnemyWrapper*, std::vector<InfluenceMap::Source>> dangerSources;
+
+    void rebuildBlockers();
+    void refreshEnemyCell(int x, int y);
+    void journalCell(int idx);
+    std::vector<InfluenceMap::Source> dangerSourcesOf(const EnemyWrapper &enemy) const;
+    void writeDangerLayer();
+    void writeDanger(const InfluenceMap::Box &box);
+
     friend class GameController; // Allow GameController access if needed
 };
 
@@ -74,11 +74,19 @@ bool GameStateManager::newGame(GameModel *model, QMap<int, std::shared_ptr<Cache
 
     std::vector<std::unique_ptr<Portal>> portalWrappers; // local to store portals
 
+    // The grid and its regions come first, so the forward portal lands where the protagonist can walk
+    model->setTiles(std::move(tileWrappers), rows, cols);
+    model->setHierarchy(std::make_shared<HierarchicalGraph>(*model->getSearchGrid()));
+    model->setLandmarks(std::make_shared<LandmarkTable>(*model->getSearchGrid()));
+    model->setRegions(std::make_shared<RegionLabels>(*model->getSearchGrid()));
+    // Built offline by --build-path-databases; levels without one just search
+    model->setPathDatabase(CompressedPathDatabase::load(
+        CompressedPathDatabase::fileFor(model->getLevelFiles()[lvl]), *model->getSearchGrid()));
 
     QPoint randCoord = pickRandomValidTile(
-        tileWrappers,
-        rows,
-        cols
+        *model->getSearchGrid(),
+        *model->getRegions(),
+        QPoint(protagonist->getXPos(), protagonist->getYPos())
         );
     auto forwardTile = std::make_unique<Tile>(randCoord.x(), randCoord.y(), 0.0f);
     portalWrappers.push_back(std::make_unique<Portal>(std::move(forwardTile), lvl+1,0,0));
@@ -93,7 +101,6 @@ bool GameStateManager::newGame(GameModel *model, QMap<int, std::shared_ptr<Cache
         portalWrappers.push_back(std::make_unique<Portal>(std::move(backwardTile), lvl-1,prevForwardCoord.x(),prevForwardCoord.y()));
 
     }
-    model->setTiles(std::move(tileWrappers), rows, cols);
     model->setProtagonist(std::move(protagonist));
     model->setEnemies(std::move(enemyWrappers));
     model->setHealthPacks(std::move(hpWrappers));
@@ -105,39 +112,54 @@ bool GameStateManager::newGame(GameModel *model, QMap<int, std::shared_ptr<Cache
     return true;
 }
 QPoint GameStateManager::pickRandomValidTile(
-    const std::vector<std::unique_ptr<TileWrapper>> &tiles,
-    int rows,
-    int cols
+    const SearchGrid &grid,
+    const RegionLabels &regions,
+    const QPoint &reachableFrom
     ) {
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distX(0, cols - 1);
-    std::uniform_int_distribution<> distY(0, rows - 1);
-
-    while (true) {
-        int x = distX(gen);
-        int y = distY(gen);
-
-        // Skip (0,0)
-        if (x == 0 && y == 0) {
-            continue;
+    std::uniform_int_distribution<> distX(0, grid.getCols() - 1);
+    std::uniform_int_distribution<> distY(0, grid.getRows() - 1);
+
+    int from = grid.index(reachableFrom.x(), reachableFrom.y());
+    auto valid = [&](int x, int y) {
+        // Skip (0,0) and the protagonist's own tile; walls and sealed-off pockets have another region
+        if ((x == 0 && y == 0) || (x == reachableFrom.x() && y == reachableFrom.y())) return false;
+        return regions.connected(from, grid.index(x, y));
+    };
+
+    if (grid.inBounds(reachableFrom.x(), reachableFrom.y())) {
+        for (int attempt = 0; attempt < 10000; ++attempt) {
+            int x = distX(gen);
+            int y = distY(gen);
+            if (valid(x, y)) return QPoint(x, y);
         }
-
-        // Find the tile in 'tiles'
-        for (auto &tw : tiles) {
-            if (tw->getXPos() == x && tw->getYPos() == y) {
-                if (tw->getValue() != std::numeric_limits<float>::infinity()) {
-                    // Valid tile
-                    return QPoint(x, y);
-                }
-                break;
-            }
+        // Tiny region: take the first tile of it
+        for (int cell = 0; cell < grid.size(); ++cell) {
+            if (valid(grid.xOf(cell), grid.yOf(cell))) return QPoint(grid.xOf(cell), grid.yOf(cell));
         }
     }
-    // Technically never returns here
+
+    // The protagonist is walled in on its own: any passable tile, as before
+    for (int cell = 1; cell < grid.size(); ++cell) {
+        if (grid.isPassable(cell)) return QPoint(grid.xOf(cell), grid.yOf(cell));
+    }
     return QPoint(-1, -1);
 }
 
+bool GameStateManager::cacheLevel(int level, QMap<int, std::shared_ptr<CachedLevel>> &levelCache)
+{
+    if (levelCache.contains(level)) return true;
+    // Same generation as a visit, on a scratch model nobody is listening to
+    GameModel scratch;
+    if (level < 0 || level >= scratch.getLevelFiles().size()) return false;
+    // The backward portal leads to the previous level's forward portal, so that one comes first
+    if (level > 0 && !cacheLevel(level - 1, levelCache)) return false;
+
+    scratch.setCurrentLevel(level);
+    return newGame(&scratch, levelCache);
+}
+
 bool GameStateManager::restartGame(GameModel *model, QMap<int, std::shared_ptr<CachedLevel>> &levelCache)
 {
     levelCache.clear();
@@ -326,6 +348,10 @@ bool GameStateManager::loadGameFromFile(GameModel *model, QMap<int, std::shared_
     }
 
     model->setTiles(std::move(tileWrappers), rows, cols);
+    model->setHierarchy(std::make_shared<HierarchicalGraph>(*model->getSearchGrid()));
+    model->setLandmarks(std::make_shared<LandmarkTable>(*model->getSearchGrid()));
+    model->setRegions(std::make_shared<RegionLabels>(*model->getSearchGrid()));
+    model->setPathDatabase(CompressedPathDatabase::load(CompressedPathDatabase::fileFor(levelFile), *model->getSearchGrid()));
     model->setProtagonist(std::move(protagonist));
     model->setEnemies(std::move(enemies));
     model->setHealthPacks(std::move(hps));
@@ -349,6 +375,10 @@ void GameStateManager::loadLevelFromCache(GameModel *model, QMap<int, std::share
 
     auto cached = it.value(); // std::shared_ptr<CachedLevel>
     model->setTiles(cloneTiles(cached->tiles), cached->rows, cached->cols);
+    model->setHierarchy(cached->hierarchy);
+    model->setLandmarks(cached->landmarks);
+    model->setRegions(cached->regions);
+    model->setPathDatabase(cached->pathDatabase);
 
     {
         auto origP = cached->protagonist->getRaw();
@@ -371,6 +401,10 @@ void GameStateManager::cacheCurrentLevel(GameModel *model, QMap<int, std::shared
         c->forwardPortalCoord = forwardPortalCoord;
     }
     c->tiles = cloneTiles(model->getTiles());
+    c->hierarchy = model->getHierarchy();
+    c->landmarks = model->getLandmarks();
+    c->regions = model->getRegions();
+    c->pathDatabase = model->getPathDatabase();
     {
         auto origP = model->getProtagonist()->getRaw();
         auto newProtag = std::make_unique<Protagonist>();
@@ -18,6 +18,10 @@ public:
         int rows;
         int cols;
         QPoint forwardPortalCoord = QPoint(-1, -1);
+        std::shared_ptr<const HierarchicalGraph> hierarchy; // HPA* abstraction, depends on tiles only
+        std::shared_ptr<const LandmarkTable> landmarks;     // ALT heuristic tables, tiles only as well
+        std::shared_ptr<const RegionLabels> regions;        // connected regions of the tiles
+        std::shared_ptr<const CompressedPathDatabase> pathDatabase; // loaded from disk, may be null
     };
 
     GameStateManager() = default;
@@ -37,6 +41,10 @@ public:
     // Load cached level
     void loadLevelFromCache(GameModel *model, QMap<int, std::shared_ptr<CachedLevel>> &levelCache, int level);
 
+    // Generates and caches level (and any level before it that isn't cached yet) without
+    // touching the live model, for routing across levels that were never visited
+    bool cacheLevel(int level, QMap<int, std::shared_ptr<CachedLevel>> &levelCache);
+
     // Cache current level
     void cacheCurrentLevel(GameModel *model, QMap<int, std::shared_ptr<CachedLevel>> &levelCache, int level, const QPoint &forwardPortalCoord);
 
@@ -50,10 +58,11 @@ private:
     // Randomly convert some enemies to XEnemies
     void convertRandomEnemiesToXEnemies(GameModel *model, std::vector<std::unique_ptr<EnemyWrapper>> &enemies, int cols, int rows);
 
+    // Random passable tile in the same region as reachableFrom, so it can actually be walked to
     QPoint pickRandomValidTile(
-        const std::vector<std::unique_ptr<TileWrapper>> &tiles,
-        int rows,
-        int cols
+        const SearchGrid &grid,
+        const RegionLabels &regions,
+        const QPoint &reachableFrom
         );
 };
 
@@ -8,9 +8,12 @@
 #include <QScrollBar>
 #include <QDebug>
 #include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <QLabel>
 #include <QMouseEvent>
+#include <QPainterPath>
 #include <QGraphicsView>
 #include <QGraphicsItem>
 #include <QDebug>
@@ -19,7 +22,8 @@
 // Top overlay image (e.g. :/images/overlay.png)
 
 GameView::GameView(GameModel *model, QWidget *parent)
-    : QWidget(parent), model(model), protagonistItem(nullptr), overlayItem(nullptr)
+    : QWidget(parent), model(model), protagonistItem(nullptr), overlayItem(nullptr),
+      previewItem(nullptr), hoveredTile(-1, -1)
 {
     scene = new QGraphicsScene(this);
     graphicsView = new QGraphicsView(scene, this);
@@ -29,6 +33,9 @@ GameView::GameView(GameModel *model, QWidget *parent)
 
     graphicsView->setMouseTracking(true);
     graphicsView->installEventFilter(this);
+    // Mouse moves are delivered to the viewport, not the view itself
+    graphicsView->viewport()->setMouseTracking(true);
+    graphicsView->viewport()->installEventFilter(this);
 
     statusTextEdit = new QTextEdit(this);
     statusTextEdit->setReadOnly(true);
@@ -45,6 +52,7 @@ GameView::GameView(GameModel *model, QWidget *parent)
     connect(model, &GameModel::modelUpdated, this, &GameView::updateView);
     connect(model, &GameModel::gameOver, this, &GameView::handleGameOver);
     connect(model, &GameModel::modelReset, this, &GameView::handleModelReset);
+    connect(model, &GameModel::poiDistancesProgress, this, &GameView::updateStatus);
 }
 
 GameView::~GameView()
@@ -61,6 +69,8 @@ void GameView::handleModelReset()
     portalItems.clear();
     protagonistItem = nullptr;
     overlayItem = nullptr;
+    previewItem = nullptr;
+    hoveredTile = QPoint(-1, -1);
     setupScene();
     updateStatus();
 }
@@ -239,6 +249,27 @@ void GameView::updateStatus()
                              .arg(p->getEnergy())
                              .arg(model->getCurrentLevel()+1);
 
+    // Path costs from the level start, once the background distance matrix has them
+    std::shared_ptr<const PoiDistanceMatrix> distances = model->getPoiDistances();
+    SearchGrid *grid = model->getSearchGrid();
+    if (distances && grid) {
+        if (!distances->isComplete()) {
+            statusText.append(QString("\nMapping routes: %1%")
+                                  .arg(100 * distances->getRowsDone() / std::max(1, distances->getRowCount())));
+        }
+        int start = distances->getStartCell();
+        for (auto &portal : model->getPortals()) {
+            float d = distances->distance(start, grid->index(portal->getXPos(), portal->getYPos()));
+            if (d == PoiDistanceMatrix::unknown) continue;
+            if (std::isinf(d)) {
+                statusText.append(QString("\nPortal at (%1,%2): unreachable from start").arg(portal->getXPos()).arg(portal->getYPos()));
+            } else {
+                statusText.append(QString("\nPortal at (%1,%2): %3 energy from start")
+                                      .arg(portal->getXPos()).arg(portal->getYPos()).arg(d, 0, 'f', 2));
+            }
+        }
+    }
+
     // Find nearby entities
     int radius = 3;
     int pX = p->getXPos();
@@ -359,6 +390,12 @@ bool GameView::eventFilter(QObject *obj, QEvent *event)
             graphicsViewKeyPressEvent(static_cast<QKeyEvent*>(event));
             return true;
         }
+    } else if (obj == graphicsView->viewport()) {
+        if (event->type()==QEvent::MouseMove) {
+            graphicsViewHoverEvent(static_cast<QMouseEvent*>(event)->pos());
+        } else if (event->type()==QEvent::Leave) {
+            graphicsViewHoverEvent(QPoint(-1, -1));
+        }
     }
     return QWidget::eventFilter(obj,event);
 }
@@ -412,6 +449,56 @@ void GameView::graphicsViewWheelEvent(QWheelEvent *event)
     }
 }
 
+void GameView::graphicsViewHoverEvent(const QPoint &pos)
+{
+    QPoint tile(-1, -1);
+    if (pos.x() >= 0 && pos.y() >= 0) {
+        QPointF scenePos = graphicsView->mapToScene(pos);
+        int tileX = static_cast<int>(std::floor(scenePos.x() / 32));
+        int tileY = static_cast<int>(std::floor(scenePos.y() / 32));
+        if (tileX >= 0 && tileX < model->getCols() && tileY >= 0 && tileY < model->getRows()) {
+            tile = QPoint(tileX, tileY);
+        }
+    }
+
+    // Only a new tile is worth a query; moves within a tile are dropped here
+    if (tile == hoveredTile) return;
+    hoveredTile = tile;
+    if (tile.x() < 0) clearPathPreview();
+    emit tileHovered(tile.x(), tile.y());
+}
+
+void GameView::showPathPreview(const std::vector<QPoint> &tiles, bool approximate)
+{
+    if (tiles.size() < 2) {
+        clearPathPreview();
+        return;
+    }
+
+    QPainterPath line(QPointF(tiles.front().x()*32 + 16, tiles.front().y()*32 + 16));
+    for (size_t i = 1; i < tiles.size(); ++i) {
+        line.lineTo(tiles[i].x()*32 + 16, tiles[i].y()*32 + 16);
+    }
+
+    if (!previewItem) {
+        previewItem = scene->addPath(QPainterPath());
+        previewItem->setZValue(3);
+    }
+    QPen pen(QColor(0, 170, 255), 4);
+    pen.setCosmetic(true);
+    pen.setCapStyle(Qt::RoundCap);
+    pen.setJoinStyle(Qt::RoundJoin);
+    if (approximate) pen.setStyle(Qt::DashLine);
+    previewItem->setPen(pen);
+    previewItem->setPath(line);
+    previewItem->setVisible(true);
+}
+
+void GameView::clearPathPreview()
+{
+    if (previewItem) previewItem->setVisible(false);
+}
+
 void GameView::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
@@ -8,8 +8,10 @@
 #include <QMap>
 #include <QGraphicsRectItem>
 #include <QGraphicsPixmapItem>
+#include <QGraphicsPathItem>
 #include <QProgressBar>
 #include <memory>
+#include <vector>
 #include "gamemodel.h"
 
 
@@ -25,10 +27,15 @@ public:
     void setOverlayImage(const QString &path); // Set a new overlay image
     void setUniversalOverlayImage(const QString &path);
 
+    // Hover preview: a line through the tile centres, dashed while it is only an approximation
+    void showPathPreview(const std::vector<QPoint> &tiles, bool approximate);
+    void clearPathPreview();
+
 signals:
     void moveRequest(int dx, int dy);
     void autoPlayRequest();
     void tileSelected(int x, int y);
+    void tileHovered(int x, int y); // (-1,-1) when the cursor leaves the map
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -51,6 +58,7 @@ private:
 
     void graphicsViewKeyPressEvent(QKeyEvent *event);
     void graphicsViewWheelEvent(QWheelEvent *event);
+    void graphicsViewHoverEvent(const QPoint &pos);
 
     GameModel *model;
     QGraphicsView *graphicsView;
@@ -68,6 +76,9 @@ private:
 
     QGraphicsPixmapItem *overlayItem; // Overlay image item
     QString currentOverlayPath;      // Path to the overlay image
+
+    QGraphicsPathItem *previewItem;  // Hover path preview, created on first use
+    QPoint hoveredTile;              // Tile under the cursor, (-1,-1) if none
 };
 
 #endif // GAMEVIEW_H
@@ -0,0 +1,318 @@
+#include "hierarchicalgraph.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+
+namespace {
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+struct QueueEntry {
+    float cost;
+    int index;
+    bool operator>(const QueueEntry &other) const { return cost > other.cost; }
+};
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+}
+
+HierarchicalGraph::HierarchicalGraph(const SearchGrid &grid, int clusterSize)
+    : clusterSize(clusterSize),
+    clustersX((grid.getCols() + clusterSize - 1) / clusterSize),
+    clustersY((grid.getRows() + clusterSize - 1) / clusterSize),
+    minStepCost(kInf)
+{
+    for (int i = 0; i < grid.size(); ++i) {
+        minStepCost = std::min(minStepCost, grid.getStepCost(i));
+    }
+    if (minStepCost == kInf) minStepCost = 0.0f;
+
+    clusterNodes.resize(static_cast<size_t>(clustersX) * clustersY);
+    findEntrances(grid);
+
+    // Each cluster only appends to the edge lists of its own border nodes, so clusters build in parallel
+    std::atomic<int> nextCluster(0);
+    int clusterCount = static_cast<int>(clusterNodes.size());
+    auto worker = [this, &grid, &nextCluster, clusterCount]() {
+        for (int c = nextCluster++; c < clusterCount; c = nextCluster++) {
+            buildIntraEdges(grid, c);
+        }
+    };
+
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) t.join();
+}
+
+int HierarchicalGraph::nodeFor(const SearchGrid &grid, int cell)
+{
+    auto it = cellToNode.find(cell);
+    if (it != cellToNode.end()) return it->second;
+
+    int node = static_cast<int>(nodeCell.size());
+    nodeCell.push_back(cell);
+    edges.emplace_back();
+    cellToNode.emplace(cell, node);
+    clusterNodes[clusterOf(grid.xOf(cell), grid.yOf(cell))].push_back(node);
+    return node;
+}
+
+void HierarchicalGraph::addEntrance(const SearchGrid &grid, int a, int b)
+{
+    int na = nodeFor(grid, a);
+    int nb = nodeFor(grid, b);
+    // Edge cost is the cost of entering the destination cell, so the graph is directed
+    edges[na].push_back({nb, grid.getStepCost(b)});
+    edges[nb].push_back({na, grid.getStepCost(a)});
+}
+
+void HierarchicalGraph::findEntrances(const SearchGrid &grid)
+{
+    int rows = grid.getRows();
+    int cols = grid.getCols();
+    auto passable = [&grid](int x, int y) {
+        return grid.inBounds(x, y) && grid.isPassable(grid.index(x, y));
+    };
+
+    // A maximal run of open border cells gets one entrance in the middle, long runs one at each end
+    auto addRun = [this, &grid](int runStart, int runEnd, const std::function<std::pair<int,int>(int)> &cellsAt) {
+        if (runEnd - runStart + 1 < 6) {
+            auto ab = cellsAt((runStart + runEnd) / 2);
+            addEntrance(grid, ab.first, ab.second);
+        } else {
+            auto first = cellsAt(runStart);
+            auto last = cellsAt(runEnd);
+            addEntrance(grid, first.first, first.second);
+            addEntrance(grid, last.first, last.second);
+        }
+    };
+
+    // Vertical borders between cluster columns
+    for (int x = clusterSize; x < cols; x += clusterSize) {
+        auto cellsAt = [&grid, x](int y) { return std::make_pair(grid.index(x - 1, y), grid.index(x, y)); };
+        for (int y0 = 0; y0 < rows; y0 += clusterSize) {
+            int yEnd = std::min(rows, y0 + clusterSize);
+            int runStart = -1;
+            for (int y = y0; y <= yEnd; ++y) {
+                bool open = y < yEnd && passable(x - 1, y) && passable(x, y);
+                if (open && runStart < 0) runStart = y;
+                if (!open && runStart >= 0) {
+                    addRun(runStart, y - 1, cellsAt);
+                    runStart = -1;
+                }
+            }
+        }
+        // Diagonal-only crossings (both corner cells are walls) need their own entrance
+        for (int y = 0; y + 1 < rows; ++y) {
+            if (passable(x - 1, y) && passable(x, y + 1) && !passable(x, y) && !passable(x - 1, y + 1)) {
+                addEntrance(grid, grid.index(x - 1, y), grid.index(x, y + 1));
+            }
+            if (passable(x - 1, y + 1) && passable(x, y) && !passable(x - 1, y) && !passable(x, y + 1)) {
+                addEntrance(grid, grid.index(x - 1, y + 1), grid.index(x, y));
+            }
+        }
+    }
+
+    // Horizontal borders between cluster rows
+    for (int y = clusterSize; y < rows; y += clusterSize) {
+        auto cellsAt = [&grid, y](int x) { return std::make_pair(grid.index(x, y - 1), grid.index(x, y)); };
+        for (int x0 = 0; x0 < cols; x0 += clusterSize) {
+            int xEnd = std::min(cols, x0 + clusterSize);
+            int runStart = -1;
+            for (int x = x0; x <= xEnd; ++x) {
+                bool open = x < xEnd && passable(x, y - 1) && passable(x, y);
+                if (open && runStart < 0) runStart = x;
+                if (!open && runStart >= 0) {
+                    addRun(runStart, x - 1, cellsAt);
+                    runStart = -1;
+                }
+            }
+        }
+        for (int x = 0; x + 1 < cols; ++x) {
+            // Crossings at cluster corners were already handled with the vertical border
+            if ((x + 1) % clusterSize == 0) continue;
+            if (passable(x, y - 1) && passable(x + 1, y) && !passable(x + 1, y - 1) && !passable(x, y)) {
+                addEntrance(grid, grid.index(x, y - 1), grid.index(x + 1, y));
+            }
+            if (passable(x + 1, y - 1) && passable(x, y) && !passable(x, y - 1) && !passable(x + 1, y)) {
+                addEntrance(grid, grid.index(x + 1, y - 1), grid.index(x, y));
+            }
+        }
+    }
+}
+
+void HierarchicalGraph::buildIntraEdges(const SearchGrid &grid, int cluster)
+{
+    const auto &nodes = clusterNodes[cluster];
+    int x0 = (cluster % clustersX) * clusterSize;
+    int y0 = (cluster / clustersX) * clusterSize;
+    int w = std::min(clusterSize, grid.getCols() - x0);
+
+    std::vector<float> dist;
+    for (int from : nodes) {
+        clusterDistances(grid, cluster, nodeCell[from], false, 0, -1, dist);
+        for (int to : nodes) {
+            if (to == from) continue;
+            int cell = nodeCell[to];
+            float d = dist[(grid.yOf(cell) - y0) * w + (grid.xOf(cell) - x0)];
+            if (d != kInf) edges[from].push_back({to, d});
+        }
+    }
+}
+
+void HierarchicalGraph::clusterDistances(const SearchGrid &grid, int cluster, int source, bool reverse,
+                                         uint8_t blockerMask, int exemptCell, std::vector<float> &dist) const
+{
+    int x0 = (cluster % clustersX) * clusterSize;
+    int y0 = (cluster / clustersX) * clusterSize;
+    int w = std::min(clusterSize, grid.getCols() - x0);
+    int h = std::min(clusterSize, grid.getRows() - y0);
+
+    auto enterCost = [&grid, blockerMask, exemptCell](int cell) {
+        return cell == exemptCell ? grid.getStepCost(cell) : grid.getStepCost(cell, blockerMask);
+    };
+
+    dist.assign(static_cast<size_t>(w) * h, kInf);
+    int sx = grid.xOf(source) - x0;
+    int sy = grid.yOf(source) - y0;
+    dist[sy * w + sx] = 0.0f;
+
+    MinQueue queue;
+    queue.push({0.0f, sy * w + sx});
+    while (!queue.empty()) {
+        QueueEntry current = queue.top();
+        queue.pop();
+        if (current.cost > dist[current.index]) continue;
+
+        int lx = current.index % w;
+        int ly = current.index / w;
+        int cell = grid.index(x0 + lx, y0 + ly);
+        // Walking backwards, every move into the current cell pays that cell's cost
+        float reverseStep = reverse ? enterCost(cell) : 0.0f;
+        if (reverseStep == kInf) continue;
+
+        for (int d = 0; d < 8; ++d) {
+            int nx = lx + SearchGrid::dirDx[d];
+            int ny = ly + SearchGrid::dirDy[d];
+            if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
+
+            int next = grid.index(x0 + nx, y0 + ny);
+            float step = reverse ? reverseStep : enterCost(next);
+            if (reverse && !grid.isPassable(next)) continue;
+            if (step == kInf) continue;
+
+            float cost = current.cost + step;
+            if (cost < dist[ny * w + nx]) {
+                dist[ny * w + nx] = cost;
+                queue.push({cost, ny * w + nx});
+            }
+        }
+    }
+}
+
+bool HierarchicalGraph::isLongRange(const SearchGrid &grid, int start, int goal) const
+{
+    int dx = std::abs(grid.xOf(start) - grid.xOf(goal));
+    int dy = std::abs(grid.yOf(start) - grid.yOf(goal));
+    return std::max(dx, dy) > 2 * clusterSize;
+}
+
+std::vector<int> HierarchicalGraph::findWaypoints(const SearchGrid &grid, int start, int goal, uint8_t blockerMask) const
+{
+    if (start == goal || !grid.isPassable(goal)) return {};
+
+    const int nodeCount = static_cast<int>(nodeCell.size());
+    const int startNode = nodeCount;
+    const int goalNode = nodeCount + 1;
+    int startCluster = clusterOf(grid.xOf(start), grid.yOf(start));
+    int goalCluster = clusterOf(grid.xOf(goal), grid.yOf(goal));
+
+    auto localIndex = [this, &grid](int cluster, int cell) {
+        int x0 = (cluster % clustersX) * clusterSize;
+        int y0 = (cluster / clustersX) * clusterSize;
+        int w = std::min(clusterSize, grid.getCols() - x0);
+        return (grid.yOf(cell) - y0) * w + (grid.xOf(cell) - x0);
+    };
+
+    // Attach start and goal to the entrances of their clusters, honouring blockers there
+    std::vector<Edge> startEdges;
+    std::vector<float> goalCost(nodeCount + 2, kInf);
+    std::vector<float> dist;
+
+    clusterDistances(grid, startCluster, start, false, blockerMask, goal, dist);
+    for (int n : clusterNodes[startCluster]) {
+        float d = dist[localIndex(startCluster, nodeCell[n])];
+        if (d != kInf) startEdges.push_back({n, d});
+    }
+    if (startCluster == goalCluster) {
+        float d = dist[localIndex(startCluster, goal)];
+        if (d != kInf) startEdges.push_back({goalNode, d});
+    }
+
+    clusterDistances(grid, goalCluster, goal, true, blockerMask, goal, dist);
+    for (int n : clusterNodes[goalCluster]) {
+        goalCost[n] = dist[localIndex(goalCluster, nodeCell[n])];
+    }
+
+    auto cellOf = [this, start, goal, startNode](int node) {
+        return node == startNode ? start : (node < startNode ? nodeCell[node] : goal);
+    };
+    auto heuristic = [this, &grid, goal](int cell) {
+        int dx = std::abs(grid.xOf(cell) - grid.xOf(goal));
+        int dy = std::abs(grid.yOf(cell) - grid.yOf(goal));
+        return minStepCost * static_cast<float>(std::max(dx, dy));
+    };
+
+    std::vector<float> g(nodeCount + 2, kInf);
+    std::vector<int> parent(nodeCount + 2, -1);
+    MinQueue open;
+    g[startNode] = 0.0f;
+    open.push({heuristic(start), startNode});
+
+    while (!open.empty()) {
+        QueueEntry current = open.top();
+        open.pop();
+        int node = current.index;
+        if (current.cost > g[node] + heuristic(cellOf(node))) continue;
+
+        if (node == goalNode) {
+            std::vector<int> waypoints;
+            for (int n = goalNode; n != startNode; n = parent[n]) {
+                int cell = cellOf(n);
+                if (cell != start && (waypoints.empty() || waypoints.back() != cell)) {
+                    waypoints.push_back(cell);
+                }
+            }
+            std::reverse(waypoints.begin(), waypoints.end());
+            return waypoints;
+        }
+
+        auto relax = [&](int next, float cost) {
+            float newG = g[node] + cost;
+            if (newG < g[next]) {
+                g[next] = newG;
+                parent[next] = node;
+                open.push({newG + heuristic(cellOf(next)), next});
+            }
+        };
+
+        if (node == startNode) {
+            for (const Edge &e : startEdges) relax(e.target, e.cost);
+            continue;
+        }
+        for (const Edge &e : edges[node]) {
+            // Entrances occupied by enemies (or guarded portals) are closed for this query
+            if (e.target != goalNode && grid.isBlocked(nodeCell[e.target], blockerMask)) continue;
+            relax(e.target, e.cost);
+        }
+        if (goalCost[node] != kInf) relax(goalNode, goalCost[node]);
+    }
+
+    return {};
+}
@@ -0,0 +1,64 @@
+#ifndef HIERARCHICALGRAPH_H
+#define HIERARCHICALGRAPH_H
+
+#include "searchgrid.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief HPA* abstraction of a level: square clusters, entrances on their borders,
+ *        and an abstract graph of precomputed intra-cluster distances.
+ *
+ * Built once when a level loads (GameStateManager::newGame) and kept in the
+ * CachedLevel, so portal round trips reuse it. Only static tile costs are baked in;
+ * enemies and portals are respected when start/goal are attached to the graph and
+ * when each leg is refined on the full grid.
+ */
+class HierarchicalGraph {
+public:
+    static constexpr int defaultClusterSize = 32;
+
+    explicit HierarchicalGraph(const SearchGrid &grid, int clusterSize = defaultClusterSize);
+
+    // True when start and goal are far enough apart that the abstract graph pays off.
+    bool isLongRange(const SearchGrid &grid, int start, int goal) const;
+
+    /**
+     * @brief Abstract route from start to goal as a list of cells to walk through, ending at goal.
+     * Consecutive waypoints lie in the same cluster or across one border, so each leg is a cheap
+     * local search. Returns an empty list if the goal is unreachable.
+     */
+    std::vector<int> findWaypoints(const SearchGrid &grid, int start, int goal, uint8_t blockerMask) const;
+
+    int getClusterSize() const noexcept { return clusterSize; }
+    int getNodeCount() const noexcept { return static_cast<int>(nodeCell.size()); }
+
+private:
+    struct Edge {
+        int target;
+        float cost;
+    };
+
+    int clusterOf(int x, int y) const noexcept { return (y / clusterSize) * clustersX + (x / clusterSize); }
+    int nodeFor(const SearchGrid &grid, int cell);
+    void addEntrance(const SearchGrid &grid, int a, int b);
+    void findEntrances(const SearchGrid &grid);
+    void buildIntraEdges(const SearchGrid &grid, int cluster);
+
+    // Costs from source (or, when reverse, to source) for every cell of the cluster.
+    void clusterDistances(const SearchGrid &grid, int cluster, int source, bool reverse,
+                          uint8_t blockerMask, int exemptCell, std::vector<float> &dist) const;
+
+    int clusterSize;
+    int clustersX;
+    int clustersY;
+    float minStepCost;
+
+    std::vector<int> nodeCell;                  // abstract node -> grid cell
+    std::unordered_map<int, int> cellToNode;
+    std::vector<std::vector<int>> clusterNodes; // cluster -> abstract nodes on its border
+    std::vector<std::vector<Edge>> edges;
+};
+
+#endif // HIERARCHICALGRAPH_H
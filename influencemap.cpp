@@ -0,0 +1,82 @@
+#include "influencemap.h"
+#include <algorithm>
+#include <map>
+
+void InfluenceMap::rebuild(int r, int c, const std::vector<Source> &sources)
+{
+    rows = r;
+    cols = c;
+    values.assign(static_cast<size_t>(rows) * cols, 0.0f);
+
+    std::map<int, std::vector<Source>> byRadius;
+    for (const Source &s : sources) {
+        if (s.x >= 0 && s.x < cols && s.y >= 0 && s.y < rows && s.amplitude != 0.0f) byRadius[std::max(0, s.radius)].push_back(s);
+    }
+
+    for (auto &[radius, group] : byRadius) {
+        // A few small squares are cheaper to stamp than two passes over the whole level
+        size_t side = 2 * static_cast<size_t>(radius) + 1;
+        if (group.size() * side * side < values.size()) {
+            for (const Source &s : group) add(s);
+        } else {
+            addBoxes(radius, group);
+        }
+    }
+}
+
+void InfluenceMap::addBoxes(int radius, const std::vector<Source> &sources)
+{
+    impulse.assign(values.size(), 0.0f);
+    for (const Source &s : sources) impulse[static_cast<size_t>(s.y) * cols + s.x] += s.amplitude;
+
+    // Horizontal pass: every cell sums the impulses within radius along its row
+    rowSums.assign(values.size(), 0.0f);
+    for (int y = 0; y < rows; ++y) {
+        const float *in = &impulse[static_cast<size_t>(y) * cols];
+        float *out = &rowSums[static_cast<size_t>(y) * cols];
+        float sum = 0.0f;
+        for (int x = 0; x < std::min(radius, cols); ++x) sum += in[x];
+        for (int x = 0; x < cols; ++x) {
+            if (x + radius < cols) sum += in[x + radius];
+            out[x] = sum;
+            if (x - radius >= 0) sum -= in[x - radius];
+        }
+    }
+
+    // Vertical pass: a running sum of whole rows, so the inner loop is along x as well
+    window.assign(cols, 0.0f);
+    for (int y = 0; y < std::min(radius, rows); ++y) {
+        const float *in = &rowSums[static_cast<size_t>(y) * cols];
+        for (int x = 0; x < cols; ++x) window[x] += in[x];
+    }
+    for (int y = 0; y < rows; ++y) {
+        if (y + radius < rows) {
+            const float *in = &rowSums[static_cast<size_t>(y + radius) * cols];
+            for (int x = 0; x < cols; ++x) window[x] += in[x];
+        }
+        float *out = &values[static_cast<size_t>(y) * cols];
+        for (int x = 0; x < cols; ++x) out[x] += window[x];
+        if (y - radius >= 0) {
+            const float *in = &rowSums[static_cast<size_t>(y - radius) * cols];
+            for (int x = 0; x < cols; ++x) window[x] -= in[x];
+        }
+    }
+}
+
+InfluenceMap::Box InfluenceMap::footprint(const Source &s) const
+{
+    int radius = std::max(0, s.radius);
+    return {std::max(0, s.x - radius), std::max(0, s.y - radius),
+            std::min(cols - 1, s.x + radius), std::min(rows - 1, s.y + radius)};
+}
+
+InfluenceMap::Box InfluenceMap::add(const Source &s, float sign)
+{
+    Box box = footprint(s);
+    float amount = sign * s.amplitude;
+    for (int y = box.y0; y <= box.y1; ++y) {
+        float *row = &values[static_cast<size_t>(y) * cols];
+        for (int x = box.x0; x <= box.x1; ++x) row[x] += amount;
+    }
+    return box;
+}
@@ -0,0 +1,52 @@
+#ifndef INFLUENCEMAP_H
+#define INFLUENCEMAP_H
+
+#include <vector>
+
+/**
+ * @brief Per-cell danger from enemies: how much health standing near them puts at risk.
+ *
+ * Every source adds its amplitude to each cell within its radius (Chebyshev distance, the
+ * reach of handlePEnemyPoison), so a cell holds the hit points at risk there. A box kernel is separable, so a
+ * full rebuild splats the sources into an impulse grid per radius and sums it with one
+ * horizontal and one vertical sliding-window pass; both inner loops run along rows and
+ * vectorize. A box is also exactly additive, so a single enemy dying or teleporting is
+ * removed or moved by touching only its own square.
+ */
+class InfluenceMap {
+public:
+    struct Source {
+        int x;
+        int y;
+        int radius;
+        float amplitude;
+    };
+
+    // Cells one source covers, clipped to the map (inclusive bounds; empty if x0 > x1)
+    struct Box {
+        int x0, y0, x1, y1;
+    };
+
+    void rebuild(int rows, int cols, const std::vector<Source> &sources);
+    // Adds the source, or takes it away again with sign -1
+    Box add(const Source &source, float sign = 1.0f);
+    Box footprint(const Source &source) const;
+
+    // Rounding residue that incremental updates leave behind reads as exactly zero
+    float at(int idx) const noexcept { return values[idx] > 1e-3f ? values[idx] : 0.0f; }
+    int getRows() const noexcept { return rows; }
+    int getCols() const noexcept { return cols; }
+
+private:
+    void addBoxes(int radius, const std::vector<Source> &sources);
+
+    int rows = 0;
+    int cols = 0;
+    std::vector<float> values;
+    // Scratch for the separable passes, kept between rebuilds
+    std::vector<float> impulse;
+    std::vector<float> rowSums;
+    std::vector<float> window;
+};
+
+#endif // INFLUENCEMAP_H
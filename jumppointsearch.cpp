@@ -0,0 +1,152 @@
+#include "jumppointsearch.h"
+#include "landmarks.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+JumpPointSearch::JumpPointSearch(const SearchGrid &grid, SearchWorkspace &workspace)
+    : grid(grid), ws(workspace), goal(-1), blockerMask(0), stepCost(0.0f)
+{}
+
+bool JumpPointSearch::walkable(int x, int y) const noexcept
+{
+    if (!grid.inBounds(x, y)) return false;
+    int idx = grid.index(x, y);
+    if (!grid.isPassable(idx)) return false;
+    return idx == goal || !grid.isBlocked(idx, blockerMask);
+}
+
+float JumpPointSearch::heuristic(int idx) const noexcept
+{
+    // Diagonals cost one step, so the exact obstacle-free distance is Chebyshev
+    int dx = std::abs(grid.xOf(idx) - grid.xOf(goal));
+    int dy = std::abs(grid.yOf(idx) - grid.yOf(goal));
+    float chebyshev = stepCost * static_cast<float>(std::max(dx, dy));
+    // Landmarks see the walls in between, which is what keeps maze searches narrow
+    const LandmarkTable *landmarks = grid.getLandmarks();
+    return landmarks ? std::max(chebyshev, landmarks->lowerBound(idx, goal)) : chebyshev;
+}
+
+int JumpPointSearch::jump(int x, int y, int dx, int dy) const noexcept
+{
+    while (true) {
+        x += dx;
+        y += dy;
+        if (!walkable(x, y)) return -1;
+
+        int idx = grid.index(x, y);
+        if (idx == goal) return idx;
+
+        if (dx != 0 && dy != 0) {
+            if ((!walkable(x - dx, y) && walkable(x - dx, y + dy)) ||
+                (!walkable(x, y - dy) && walkable(x + dx, y - dy))) {
+                return idx;
+            }
+            // A diagonal jump stops wherever a straight jump from it would find something
+            if (jump(x, y, dx, 0) != -1 || jump(x, y, 0, dy) != -1) {
+                return idx;
+            }
+        } else if (dx != 0) {
+            if ((!walkable(x, y + 1) && walkable(x + dx, y + 1)) ||
+                (!walkable(x, y - 1) && walkable(x + dx, y - 1))) {
+                return idx;
+            }
+        } else {
+            if ((!walkable(x + 1, y) && walkable(x + 1, y + dy)) ||
+                (!walkable(x - 1, y) && walkable(x - 1, y + dy))) {
+                return idx;
+            }
+        }
+    }
+}
+
+std::vector<int> JumpPointSearch::findPath(int start, int goalIdx, uint8_t mask)
+{
+    goal = goalIdx;
+    blockerMask = mask;
+    stepCost = grid.getStepCost(goal);
+    if (start == goal || stepCost == std::numeric_limits<float>::infinity()) {
+        return {};
+    }
+
+    ws.begin(grid.size());
+    ws.reach(start, 0.0f, start);
+    ws.f[start] = heuristic(start);
+    ws.push(ws.f[start], start);
+
+    while (!ws.openEmpty() && !grid.isCancelled()) {
+        SearchWorkspace::OpenEntry current = ws.pop();
+        if (current.f > ws.f[current.index]) continue;
+        ++ws.expanded;
+        if (current.index == goal) return reconstructPath(start);
+
+        int cx = grid.xOf(current.index);
+        int cy = grid.yOf(current.index);
+
+        // Pruned neighbour directions (dx, dy) for this node
+        int dirs[8][2];
+        int dirCount = 0;
+        auto addDir = [&dirs, &dirCount](int dx, int dy) {
+            dirs[dirCount][0] = dx;
+            dirs[dirCount][1] = dy;
+            ++dirCount;
+        };
+
+        if (current.index == start) {
+            for (int d = 0; d < 8; ++d) addDir(SearchGrid::dirDx[d], SearchGrid::dirDy[d]);
+        } else {
+            int p = static_cast<int>(ws.parent[current.index]);
+            int dx = (cx > grid.xOf(p)) - (cx < grid.xOf(p));
+            int dy = (cy > grid.yOf(p)) - (cy < grid.yOf(p));
+
+            if (dx != 0 && dy != 0) {
+                addDir(dx, 0);
+                addDir(0, dy);
+                addDir(dx, dy);
+                if (!walkable(cx - dx, cy)) addDir(-dx, dy);
+                if (!walkable(cx, cy - dy)) addDir(dx, -dy);
+            } else if (dx != 0) {
+                addDir(dx, 0);
+                if (!walkable(cx, cy + 1)) addDir(dx, 1);
+                if (!walkable(cx, cy - 1)) addDir(dx, -1);
+            } else {
+                addDir(0, dy);
+                if (!walkable(cx + 1, cy)) addDir(1, dy);
+                if (!walkable(cx - 1, cy)) addDir(-1, dy);
+            }
+        }
+
+        for (int i = 0; i < dirCount; ++i) {
+            int jp = jump(cx, cy, dirs[i][0], dirs[i][1]);
+            if (jp == -1) continue;
+
+            int steps = std::max(std::abs(grid.xOf(jp) - cx), std::abs(grid.yOf(jp) - cy));
+            float newG = ws.g[current.index] + stepCost * static_cast<float>(steps);
+            if (ws.isReached(jp) && newG >= ws.g[jp]) continue;
+
+            ws.reach(jp, newG, current.index);
+            ws.f[jp] = newG + heuristic(jp);
+            ws.push(ws.f[jp], jp);
+        }
+    }
+
+    return {};
+}
+
+std::vector<int> JumpPointSearch::reconstructPath(int start) const
+{
+    // Jump points are joined by straight or diagonal runs; expand each run into single steps
+    std::vector<int> path;
+    int current = goal;
+    while (current != start) {
+        int prev = static_cast<int>(ws.parent[current]);
+        int dx = grid.xOf(current) - grid.xOf(prev);
+        int dy = grid.yOf(current) - grid.yOf(prev);
+        int steps = std::max(std::abs(dx), std::abs(dy));
+        int dir = SearchGrid::directionBetween(0, 0, (dx > 0) - (dx < 0), (dy > 0) - (dy < 0));
+        path.insert(path.end(), steps, dir);
+        current = prev;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
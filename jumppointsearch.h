@@ -0,0 +1,37 @@
+#ifndef JUMPPOINTSEARCH_H
+#define JUMPPOINTSEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Jump point search over the 8-connected level grid.
+ *
+ * Only exact on uniform-cost grids (SearchGrid::findPath falls back to A* otherwise).
+ * Jumps are evaluated online rather than from precomputed JPS+ distances, because
+ * enemies and portals change the blocked set during a level and would invalidate them.
+ * Diagonal steps cost the same as straight ones, matching moveProtagonist().
+ */
+class JumpPointSearch {
+public:
+    JumpPointSearch(const SearchGrid &grid, SearchWorkspace &workspace);
+
+    // Same contract as SearchGrid::findPath: 0-7 directions, empty if unreachable.
+    std::vector<int> findPath(int start, int goal, uint8_t blockerMask);
+
+private:
+    bool walkable(int x, int y) const noexcept;
+    int jump(int x, int y, int dx, int dy) const noexcept;
+    float heuristic(int idx) const noexcept;
+    std::vector<int> reconstructPath(int start) const;
+
+    const SearchGrid &grid;
+    SearchWorkspace &ws;
+    int goal;
+    uint8_t blockerMask;
+    float stepCost;
+};
+
+#endif // JUMPPOINTSEARCH_H
@@ -0,0 +1,151 @@
+#include "landmarks.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <thread>
+
+namespace {
+struct QueueEntry {
+    float cost;
+    int index;
+    bool operator>(const QueueEntry &other) const { return cost > other.cost; }
+};
+using MinQueue = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>>;
+}
+
+LandmarkTable::LandmarkTable(const SearchGrid &grid, int landmarkCount)
+    : count(0)
+{
+    entryCost.resize(grid.size());
+    for (int i = 0; i < grid.size(); ++i) {
+        entryCost[i] = grid.isPassable(i) ? grid.getStepCost(i) : 0.0f;
+    }
+
+    size_t cells = std::max<size_t>(1, grid.size());
+    chooseLandmarks(grid, std::min(landmarkCount, static_cast<int>(maxTableEntries / cells)));
+    count = static_cast<int>(landmarks.size());
+    distances.assign(static_cast<size_t>(grid.size()) * count, unreachable);
+    if (count == 0) return;
+
+    // One flood per landmark, each into its own array so threads never share cache lines
+    std::vector<std::vector<float>> perLandmark(count);
+    std::atomic<int> nextLandmark(0);
+    auto worker = [this, &grid, &perLandmark, &nextLandmark]() {
+        for (int l = nextLandmark++; l < count; l = nextLandmark++) {
+            flood(grid, landmarks[l], perLandmark[l]);
+        }
+    };
+
+    unsigned threadCount = std::min(static_cast<unsigned>(count), std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : threads) t.join();
+
+    // Interleave so one heuristic lookup reads a single contiguous run
+    for (int l = 0; l < count; ++l) {
+        for (int cell = 0; cell < grid.size(); ++cell) {
+            distances[static_cast<size_t>(cell) * count + l] = perLandmark[l][cell];
+        }
+    }
+}
+
+void LandmarkTable::chooseLandmarks(const SearchGrid &grid, int wanted)
+{
+    // Farthest-point selection on step counts: each landmark is the cell farthest from all
+    // earlier ones. Breadth-first hops are far cheaper than the exact floods and place
+    // landmarks just as well (corridor ends, map corners), so only the floods run in parallel.
+    if (wanted <= 0) return;
+
+    // Seed in the largest connected region; small pockets would waste every landmark
+    int seed = -1;
+    int largest = 0;
+    std::vector<int> hops(grid.size(), -1);
+    std::vector<int> frontier;
+    for (int cell = 0; cell < grid.size(); ++cell) {
+        if (hops[cell] >= 0 || !grid.isPassable(cell)) continue;
+        int size = expand(grid, cell, hops, frontier);
+        if (size > largest) {
+            largest = size;
+            seed = cell;
+        }
+    }
+    if (seed < 0) return;
+
+    std::vector<int> nearest(grid.size(), std::numeric_limits<int>::max());
+    hopDistances(grid, seed, hops);
+    int next = static_cast<int>(std::max_element(hops.begin(), hops.end()) - hops.begin());
+    while (static_cast<int>(landmarks.size()) < wanted) {
+        landmarks.push_back(next);
+        hopDistances(grid, next, hops);
+        next = -1;
+        for (int c = 0; c < grid.size(); ++c) {
+            if (hops[c] < 0) continue;
+            nearest[c] = std::min(nearest[c], hops[c]);
+            if (next < 0 || nearest[c] > nearest[next]) next = c;
+        }
+        if (next < 0 || nearest[next] == 0) break; // region smaller than the landmark count
+    }
+}
+
+void LandmarkTable::hopDistances(const SearchGrid &grid, int source, std::vector<int> &hops)
+{
+    std::vector<int> frontier;
+    hops.assign(grid.size(), -1);
+    expand(grid, source, hops, frontier);
+}
+
+int LandmarkTable::expand(const SearchGrid &grid, int source, std::vector<int> &hops, std::vector<int> &frontier)
+{
+    frontier.assign(1, source);
+    hops[source] = 0;
+    for (size_t head = 0; head < frontier.size(); ++head) {
+        int current = frontier[head];
+        int cx = grid.xOf(current);
+        int cy = grid.yOf(current);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            int next = grid.index(nx, ny);
+            if (hops[next] >= 0 || !grid.isPassable(next)) continue;
+            hops[next] = hops[current] + 1;
+            frontier.push_back(next);
+        }
+    }
+    return static_cast<int>(frontier.size());
+}
+
+void LandmarkTable::flood(const SearchGrid &grid, int source, std::vector<float> &dist) const
+{
+    dist.assign(grid.size(), unreachable);
+    dist[source] = 0.0f;
+    MinQueue queue;
+    queue.push({0.0f, source});
+
+    while (!queue.empty()) {
+        QueueEntry current = queue.top();
+        queue.pop();
+        if (current.cost > dist[current.index]) continue;
+
+        int cx = grid.xOf(current.index);
+        int cy = grid.yOf(current.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            int next = grid.index(nx, ny);
+            float cost = current.cost + grid.getStepCost(next);
+            if (cost < dist[next]) {
+                dist[next] = cost;
+                queue.push({cost, next});
+            }
+        }
+    }
+}
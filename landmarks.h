@@ -0,0 +1,82 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "searchgrid.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief ALT heuristic tables: exact distances from a few landmark cells to every cell.
+ *
+ * By the triangle inequality |d(L, goal) - d(L, n)| bounds d(n, goal) from below, so
+ * the best bound over all landmarks is an admissible and consistent heuristic that
+ * "sees" walls: in a maze it follows the corridors where straight-line distance
+ * badly underestimates. Costs are paid on entering a cell, so the backward direction
+ * is derived from the forward one: d(n, L) = d(L, n) + cost(L) - cost(n).
+ *
+ * Built once when a level loads (one Dijkstra per landmark, run in parallel) and kept in
+ * the CachedLevel like the HierarchicalGraph. Only static tile costs are baked in;
+ * blockers only make routes longer, so the bound stays admissible.
+ */
+class LandmarkTable {
+public:
+    static constexpr int defaultLandmarkCount = 8;
+    // Fewer landmarks on huge maps: at most 16M table entries (64 MB)
+    static constexpr size_t maxTableEntries = size_t(16) * 1024 * 1024;
+
+    explicit LandmarkTable(const SearchGrid &grid, int landmarkCount = defaultLandmarkCount);
+
+    // Lower bound on the cost of a path from one cell to another (0 if no landmark can tell).
+    float lowerBound(int from, int to) const noexcept
+    {
+        const float *a = &distances[static_cast<size_t>(from) * count];
+        const float *b = &distances[static_cast<size_t>(to) * count];
+        float best = 0.0f;
+        for (int l = 0; l < count; ++l) {
+            if (a[l] == unreachable || b[l] == unreachable) continue;
+            float forward = b[l] - a[l];                                    // d(L,to) - d(L,from)
+            float backward = a[l] - b[l] - entryCost[from] + entryCost[to]; // d(from,L) - d(to,L)
+            best = std::max(best, std::max(forward, backward));
+        }
+        return best;
+    }
+
+    int getLandmarkCount() const noexcept { return count; }
+    const std::vector<int>& getLandmarkCells() const noexcept { return landmarks; }
+
+private:
+    static constexpr float unreachable = std::numeric_limits<float>::infinity();
+
+    void chooseLandmarks(const SearchGrid &grid, int wanted);
+    // Breadth-first step counts from source, -1 where unreachable.
+    static void hopDistances(const SearchGrid &grid, int source, std::vector<int> &hops);
+    // Breadth-first search into cells still marked -1 in hops; returns how many it reached.
+    static int expand(const SearchGrid &grid, int source, std::vector<int> &hops, std::vector<int> &frontier);
+    void flood(const SearchGrid &grid, int source, std::vector<float> &dist) const;
+
+    int count;
+    std::vector<int> landmarks;
+    std::vector<float> distances; // cell-major: distances[cell * count + landmark]
+    std::vector<float> entryCost; // static step cost per cell, 0 for walls
+};
+
+/**
+ * @brief aStar heuristic kernel backed by a LandmarkTable.
+ * Never weaker than the obstacle-free bound (Chebyshev steps times the cheapest step).
+ */
+struct LandmarkHeuristic {
+    const LandmarkTable *table;
+    int cols;
+    float minStepCost;
+
+    float operator()(int from, int to) const noexcept
+    {
+        int dx = std::abs(from % cols - to % cols);
+        int dy = std::abs(from / cols - to / cols);
+        return std::max(table->lowerBound(from, to), minStepCost * static_cast<float>(std::max(dx, dy)));
+    }
+};
+
+#endif // LANDMARKS_H
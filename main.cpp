@@ -1,5 +1,8 @@
 #include <QApplication>
 #include "gamecontroller.h"
+#include "pathbenchmark.h"
+#include "pathdatabasetool.h"
+#include "partysimulation.h"
 
 /**
 
@@ -10,6 +13,40 @@ int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    // --benchmark-paths [queries]: compare path search variants on every level and exit
+    const QStringList args = app.arguments();
+    int benchmarkArg = args.indexOf("--benchmark-paths");
+    if (benchmarkArg >= 0) {
+        int queries = benchmarkArg + 1 < args.size() ? args[benchmarkArg + 1].toInt() : 0;
+        GameModel levels;
+        return runPathBenchmark(levels.getLevelFiles(), queries > 0 ? queries : 200);
+    }
+
+    // --build-path-databases [dir] [max cells]: write first-move tables for the level images and exit
+    int buildArg = args.indexOf("--build-path-databases");
+    if (buildArg >= 0) {
+        // Without a directory the tables land where the game loads them from
+        QString dir = buildArg + 1 < args.size() ? args[buildArg + 1] : CompressedPathDatabase::defaultDir();
+        int maxCells = buildArg + 2 < args.size() ? args[buildArg + 2].toInt() : 0;
+        GameModel levels;
+        QVector<QString> files = levels.getLevelFiles();
+        // The other maps bundled in images.qrc
+        for (const char *map : {":/images/world.png", ":/images/maze1.png", ":/images/maze2.png",
+                                ":/images/maze3.png", ":/images/worldmap4.png"}) {
+            files.append(map);
+        }
+        return runPathDatabaseBuild(files, dir, maxCells > 0 ? maxCells : CompressedPathDatabase::defaultMaxCells);
+    }
+
+    // --party [agents] [ticks]: cooperative autoplay of several protagonists on every level, headless
+    int partyArg = args.indexOf("--party");
+    if (partyArg >= 0) {
+        int agents = partyArg + 1 < args.size() ? args[partyArg + 1].toInt() : 0;
+        int ticks = partyArg + 2 < args.size() ? args[partyArg + 2].toInt() : 0;
+        GameModel levels;
+        return runPartySimulation(levels.getLevelFiles(), agents > 0 ? agents : 24, ticks > 0 ? ticks : 2000);
+    }
+
     GameController controller;
     controller.show();
 
@@ -0,0 +1,169 @@
+#include "partysimulation.h"
+#include "cooperativeplanner.h"
+#include "flowfield.h"
+#include "searchgrid.h"
+#include "world.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <unordered_set>
+
+namespace {
+
+// The agentCount passable cells closest (in steps) to origin, origin first
+std::vector<int> spawnCells(const SearchGrid &grid, int origin, int agentCount)
+{
+    std::vector<int> cells;
+    std::vector<bool> seen(grid.size(), false);
+    std::deque<int> frontier;
+    if (grid.isPassable(origin)) {
+        frontier.push_back(origin);
+        seen[origin] = true;
+    }
+    while (!frontier.empty() && static_cast<int>(cells.size()) < agentCount) {
+        int cell = frontier.front();
+        frontier.pop_front();
+        cells.push_back(cell);
+        for (int d = 0; d < 8; ++d) {
+            int nx = grid.xOf(cell) + SearchGrid::dirDx[d];
+            int ny = grid.yOf(cell) + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+            int next = grid.index(nx, ny);
+            if (seen[next] || !grid.isPassable(next)) continue;
+            seen[next] = true;
+            frontier.push_back(next);
+        }
+    }
+    return cells;
+}
+
+}
+
+int runPartySimulation(const QVector<QString> &levelFiles, int agentCount, int maxTicks)
+{
+    QTextStream out(stdout);
+    int collisionsTotal = 0;
+
+    for (const QString &file : levelFiles) {
+        World w;
+        try {
+            // Two enemies per agent, so targets outlast the first round of claims
+            w.createWorld(file, 2 * agentCount, 0);
+        } catch (...) {
+            out << "Skipping " << file << ": failed to create world\n";
+            continue;
+        }
+
+        int rows = w.getRows();
+        int cols = w.getCols();
+        std::vector<std::unique_ptr<TileWrapper>> tiles;
+        for (auto &t : w.getTiles()) {
+            tiles.push_back(std::make_unique<TileWrapper>(std::move(t)));
+        }
+        SearchGrid grid(tiles, rows, cols);
+        auto protagonist = w.getProtagonist();
+        std::vector<int> enemies;
+        for (auto &e : w.getEnemies()) {
+            if (grid.inBounds(e->getXPos(), e->getYPos())) enemies.push_back(grid.index(e->getXPos(), e->getYPos()));
+        }
+
+        CooperativePlanner planner;
+        for (int cell : spawnCells(grid, grid.index(protagonist->getXPos(), protagonist->getYPos()), agentCount)) {
+            planner.addAgent(cell);
+        }
+        int agents = planner.getAgentCount();
+
+        // Idle agents escort agent 0; they share one field toward where it was when the last pass began
+        FlowField escort;
+        planner.setSharedField(&escort);
+
+        std::vector<bool> defeated(enemies.size(), false);
+        std::vector<int> target(agents, -1); // index into enemies
+        int defeatedCount = 0;
+        auto claim = [&](int agent) {
+            // Nearest living enemy no other agent is after (Chebyshev; the planner knows the real way)
+            std::unordered_set<int> taken;
+            for (int a = 0; a < agents; ++a) {
+                if (a != agent && target[a] >= 0) taken.insert(target[a]);
+            }
+            int cell = planner.getCell(agent);
+            int best = -1;
+            int bestDistance = 0;
+            for (int e = 0; e < static_cast<int>(enemies.size()); ++e) {
+                if (defeated[e] || taken.count(e)) continue;
+                int distance = std::max(std::abs(grid.xOf(cell) - grid.xOf(enemies[e])),
+                                        std::abs(grid.yOf(cell) - grid.yOf(enemies[e])));
+                if (best < 0 || distance < bestDistance) {
+                    best = e;
+                    bestDistance = distance;
+                }
+            }
+            target[agent] = best;
+            if (best >= 0) {
+                planner.setGoal(agent, enemies[best]);
+            } else {
+                planner.setGoal(agent, agent != 0 && escort.isReady() ? escort.getGoal() : -1);
+            }
+        };
+        for (int a = 0; a < agents; ++a) claim(a);
+
+        out << file << " (" << cols << "x" << rows << ", " << agents << " agents, " << enemies.size() << " enemies)\n";
+        out.flush();
+
+        QElapsedTimer timer;
+        double totalMs = 0.0;
+        double worstMs = 0.0;
+        uint64_t expanded = 0;
+        long long planned = 0;
+        int stuck = 0;
+        int collisions = 0;
+        int ticks = 0;
+        std::vector<int> before(agents);
+        while (ticks < maxTicks && defeatedCount < static_cast<int>(enemies.size())) {
+            for (int a = 0; a < agents; ++a) before[a] = planner.getCell(a);
+
+            timer.start();
+            escort.retarget(grid, planner.getCell(0), 0);
+            escort.advance();
+            planner.tick(grid, 0);
+            double ms = timer.nsecsElapsed() / 1.0e6;
+            totalMs += ms;
+            worstMs = std::max(worstMs, ms);
+            ++ticks;
+            expanded += planner.getLastTick().expanded;
+            planned += planner.getLastTick().planned;
+            stuck += planner.getLastTick().stuck;
+
+            for (int a = 0; a < agents; ++a) {
+                for (int b = a + 1; b < agents; ++b) {
+                    bool sameCell = planner.getCell(a) == planner.getCell(b);
+                    bool swapped = planner.getCell(a) == before[b] && planner.getCell(b) == before[a] && before[a] != before[b];
+                    if (sameCell || swapped) ++collisions;
+                }
+            }
+            for (int a = 0; a < agents; ++a) {
+                int e = target[a];
+                if (e >= 0 && planner.getCell(a) == enemies[e]) {
+                    defeated[e] = true;
+                    ++defeatedCount;
+                    target[a] = -1;
+                }
+            }
+            for (int a = 0; a < agents; ++a) {
+                if (target[a] < 0 || defeated[target[a]]) claim(a);
+            }
+        }
+
+        out << QString("  %1 ticks, %2/%3 enemies defeated, %4 ms/tick (worst %5), %6 plans and %7 states/tick, %8 stuck, %9 collisions\n")
+                   .arg(ticks).arg(defeatedCount).arg(enemies.size())
+                   .arg(totalMs / std::max(1, ticks), 0, 'f', 3).arg(worstMs, 0, 'f', 3)
+                   .arg(double(planned) / std::max(1, ticks), 0, 'f', 1).arg(double(expanded) / std::max(1, ticks), 0, 'f', 0)
+                   .arg(stuck).arg(collisions);
+        out.flush();
+        collisionsTotal += collisions;
+    }
+
+    return collisionsTotal > 0 ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+#ifndef PARTYSIMULATION_H
+#define PARTYSIMULATION_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Headless party mode: agentCount protagonists clear each level together under CooperativePlanner.
+ *
+ * Run with: complete_final_project --party [agents] [ticks]
+ * Agents start around the level's protagonist and each heads for the nearest enemy no
+ * other agent has claimed; reaching it defeats it. Agents with nothing left to claim escort
+ * the first agent, planning against one FlowField that follows it a slice per tick. Prints per level the time per tick,
+ * space-time states expanded, stuck agents and any collisions (agents sharing a cell or
+ * swapping cells), which the reservation table should keep at zero.
+ * Returns the process exit code.
+ */
+int runPartySimulation(const QVector<QString> &levelFiles, int agentCount, int maxTicks);
+
+#endif // PARTYSIMULATION_H
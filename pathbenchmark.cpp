@@ -0,0 +1,218 @@
+#include "pathbenchmark.h"
+#include "searchgrid.h"
+#include "landmarks.h"
+#include "focalsearch.h"
+#include "node.h"
+#include "pathfinder_class.h"
+#include "world.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <functional>
+#include <limits>
+#include <random>
+
+namespace {
+
+struct Query {
+    int start;
+    int goal;
+};
+
+float pathCost(const SearchGrid &grid, int start, const std::vector<int> &path)
+{
+    int x = grid.xOf(start);
+    int y = grid.yOf(start);
+    float cost = 0.0f;
+    for (int d : path) {
+        x += SearchGrid::dirDx[d];
+        y += SearchGrid::dirDy[d];
+        cost += grid.getStepCost(grid.index(x, y));
+    }
+    return cost;
+}
+
+// Runs every query through search and prints average time, paths found and total path cost,
+// plus cells expanded per query when the search runs on workspace. Returns each query's path
+// cost (infinity where nothing was found).
+template <typename Search>
+std::vector<float> measure(QTextStream &out, const QString &name, const SearchGrid &grid,
+             const std::vector<Query> &queries, Search &&search, const SearchWorkspace *workspace = nullptr)
+{
+    int found = 0;
+    double totalCost = 0.0;
+    uint64_t expanded = 0;
+    std::vector<float> costs;
+    costs.reserve(queries.size());
+    QElapsedTimer timer;
+    timer.start();
+    for (const Query &q : queries) {
+        std::vector<int> path = search(q.start, q.goal);
+        if (workspace) expanded += workspace->expanded;
+        costs.push_back(std::numeric_limits<float>::infinity());
+        if (!path.empty()) {
+            ++found;
+            costs.back() = pathCost(grid, q.start, path);
+            totalCost += costs.back();
+        }
+    }
+    double msPerQuery = timer.nsecsElapsed() / 1.0e6 / std::max<size_t>(1, queries.size());
+    out << QString("  %1 %2 ms/query, %3/%4 found, total cost %5")
+               .arg(name, -28).arg(msPerQuery, 9, 'f', 3).arg(found).arg(queries.size()).arg(totalCost, 0, 'f', 3);
+    if (workspace) out << QString(", %1 expanded/query").arg(expanded / std::max<size_t>(1, queries.size()));
+    out << "\n";
+    out.flush();
+    return costs;
+}
+
+// Queries where the bucket queue's cost leaves [heap cost, heap cost + slack]; both lists
+// must find the same paths up to the bucket width, or the bucket queue is misordering.
+int countDisagreements(QTextStream &out, const QString &name, const std::vector<float> &heap,
+                       const std::vector<float> &buckets, float slack)
+{
+    constexpr float tolerance = 1e-3f; // float rounding along long paths
+    int bad = 0;
+    for (size_t i = 0; i < heap.size(); ++i) {
+        bool heapFound = heap[i] != std::numeric_limits<float>::infinity();
+        bool bucketFound = buckets[i] != std::numeric_limits<float>::infinity();
+        if (heapFound != bucketFound
+            || (heapFound && (buckets[i] < heap[i] - tolerance || buckets[i] > heap[i] + slack + tolerance))) {
+            ++bad;
+        }
+    }
+    if (bad > 0) out << "  MISMATCH " << name << ": heap and buckets disagree on " << bad << " queries\n";
+    return bad;
+}
+
+}
+
+int runPathBenchmark(const QVector<QString> &levelFiles, int queriesPerLevel)
+{
+    QTextStream out(stdout);
+    const float inf = std::numeric_limits<float>::infinity();
+    int mismatches = 0;
+
+    for (const QString &file : levelFiles) {
+        World w;
+        try {
+            w.createWorld(file, 0, 0);
+        } catch (...) {
+            out << "Skipping " << file << ": failed to create world\n";
+            continue;
+        }
+
+        int rows = w.getRows();
+        int cols = w.getCols();
+        std::vector<std::unique_ptr<TileWrapper>> tiles;
+        std::vector<Node> nodes;
+        for (auto &t : w.getTiles()) {
+            nodes.emplace_back(t->getXPos(), t->getYPos(), t->getValue());
+            tiles.push_back(std::make_unique<TileWrapper>(std::move(t)));
+        }
+        SearchGrid grid(tiles, rows, cols);
+
+        // Same queries for every variant; random passable start and goal
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> pick(0, grid.size() - 1);
+        std::vector<Query> queries;
+        for (int attempts = 0; (int)queries.size() < queriesPerLevel && attempts < queriesPerLevel * 100; ++attempts) {
+            int a = pick(rng);
+            int b = pick(rng);
+            if (a != b && grid.isPassable(a) && grid.isPassable(b)) queries.push_back({a, b});
+        }
+
+        out << file << " (" << cols << "x" << rows << ", " << queries.size() << " queries)\n";
+
+        // What autoplay and click-to-move used before SearchGrid: a fresh Node copy and
+        // std::function callbacks on every query
+        const std::vector<Node> pristine = nodes;
+        measure(out, "PathFinder<Node,Node>", grid, queries, [&](int start, int goal) {
+            nodes = pristine;
+            std::function<float(const Node&, const Node&)> cost = [inf](const Node &, const Node &b) {
+                float v = b.getValue();
+                return v == inf ? inf : 1.0f/(v+1.0f)*0.1f;
+            };
+            std::function<float(const Node&, const Node&)> heuristic = [](const Node &a, const Node &b) {
+                return std::sqrt((a.getXPos()-b.getXPos())*(a.getXPos()-b.getXPos())
+                                 + (a.getYPos()-b.getYPos())*(a.getYPos()-b.getYPos()));
+            };
+            std::function<bool(const Node&, const Node&)> comparator = [](const Node &a, const Node &b) {
+                return a.f > b.f;
+            };
+            PathFinder<Node, Node> finder(nodes, &nodes[start], &nodes[goal], comparator, (unsigned int)cols,
+                                          cost, heuristic, 1.0f);
+            return finder.A_star();
+        });
+
+        auto stepCost = [&grid](int, int to) { return grid.getStepCost(to); };
+
+        // Same kernel as below, but behind std::function to isolate the cost of type erasure
+        std::function<float(int, int)> erasedCost = stepCost;
+        std::function<float(int, int)> erasedHeuristic = EuclideanHeuristic{cols};
+        grid.setOpenListKind(OpenListKind::BinaryHeap);
+        measure(out, "aStar std::function Euclidean", grid, queries, [&](int start, int goal) {
+            return grid.aStar(start, goal, erasedCost, erasedHeuristic);
+        });
+
+        QElapsedTimer buildTimer;
+        buildTimer.start();
+        LandmarkTable landmarks(grid);
+        out << "  " << landmarks.getLandmarkCount() << " landmarks built in " << buildTimer.elapsed() << " ms\n";
+
+        // Each inlined kernel on both open lists; the admissible ones are checked against each other
+        float minStep = grid.getMinStepCost();
+        std::vector<float> heapCosts[3];
+        for (OpenListKind kind : {OpenListKind::BinaryHeap, OpenListKind::BucketQueue}) {
+            grid.setOpenListKind(kind);
+            QString queue = kind == OpenListKind::BinaryHeap ? "heap" : "buckets";
+
+            measure(out, "aStar Euclidean, " + queue, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, EuclideanHeuristic{cols});
+            }, &grid.getWorkspace());
+
+            // Scaled by the cheapest step, so admissible: optimal paths
+            std::vector<float> costs[3];
+            costs[0] = measure(out, "aStar octile, " + queue, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, OctileHeuristic{cols, minStep, minStep});
+            }, &grid.getWorkspace());
+
+            costs[1] = measure(out, "aStar zero (Dijkstra), " + queue, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, ZeroHeuristic{cols});
+            }, &grid.getWorkspace());
+
+            costs[2] = measure(out, "aStar landmarks (ALT), " + queue, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, LandmarkHeuristic{&landmarks, cols, minStep});
+            }, &grid.getWorkspace());
+
+            if (kind == OpenListKind::BinaryHeap) {
+                for (int i = 0; i < 3; ++i) heapCosts[i] = std::move(costs[i]);
+                continue;
+            }
+            // Dijkstra settles exactly on both; A* may end up one bucket width above the optimum
+            const float bucketWidth = 1.0f / BucketQueue::keyScale;
+            mismatches += countDisagreements(out, "aStar octile", heapCosts[0], costs[0], bucketWidth);
+            mismatches += countDisagreements(out, "aStar zero (Dijkstra)", heapCosts[1], costs[1], 0.0f);
+            mismatches += countDisagreements(out, "aStar landmarks (ALT)", heapCosts[2], costs[2], bucketWidth);
+        }
+
+        // Bounded-suboptimal searches: compare cost and expansions against the optimal rows above
+        for (float epsilon : {1.25f, 1.5f, 2.0f, 3.0f}) {
+            QString bound = QString::number(epsilon, 'f', 2);
+            measure(out, "weighted A* octile, eps " + bound, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, OctileHeuristic{cols, minStep, minStep}, epsilon);
+            }, &grid.getWorkspace());
+            measure(out, "weighted A* ALT, eps " + bound, grid, queries, [&](int start, int goal) {
+                return grid.aStar(start, goal, stepCost, LandmarkHeuristic{&landmarks, cols, minStep}, epsilon);
+            }, &grid.getWorkspace());
+            measure(out, "focal octile, eps " + bound, grid, queries, [&](int start, int goal) {
+                FocalSearch focal(grid, grid.getWorkspace());
+                return focal.findPath(start, goal, 0, epsilon);
+            }, &grid.getWorkspace());
+        }
+    }
+
+    if (mismatches > 0) {
+        out << "FAILED: heap and bucket queue disagree on " << mismatches << " query results\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef PATHBENCHMARK_H
+#define PATHBENCHMARK_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Times the same random queries on every level with the legacy PathFinder<Node,Node>
+ *        (std::function cost, heuristic and comparator) and with SearchGrid::aStar, both
+ *        type-erased and with inlined kernels (Euclidean, octile, zero, ALT landmarks) on the binary
+ *        heap and the bucket queue.
+ *
+ * Run with: complete_final_project --benchmark-paths [queries per level]
+ * Prints one line per level and variant; returns the process exit code, which is non-zero if
+ * the heap and the bucket queue disagree on any query's path cost.
+ */
+int runPathBenchmark(const QVector<QString> &levelFiles, int queriesPerLevel);
+
+#endif // PATHBENCHMARK_H
@@ -0,0 +1,104 @@
+#include "pathcache.h"
+#include <algorithm>
+#include <iterator>
+
+bool PathCache::lookup(int start, int goal, uint32_t flags, uint64_t version, std::vector<int> &cells)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!syncVersion(version)) {
+        ++stats.misses;
+        return false;
+    }
+
+    auto found = index.find({start, goal, flags});
+    if (found != index.end()) {
+        lru.splice(lru.begin(), lru, found->second);
+        cells = found->second->cells;
+        ++stats.hits;
+        return true;
+    }
+
+    // Every suffix of a cached route is a route to the same goal
+    auto sameGoal = byGoal.find(goalKey(goal, flags));
+    if (sameGoal != byGoal.end()) {
+        for (auto it : sameGoal->second) {
+            auto pos = std::find(it->cells.begin(), it->cells.end(), start);
+            if (pos == it->cells.end()) continue;
+            cells.assign(pos, it->cells.end());
+            lru.splice(lru.begin(), lru, it);
+            ++stats.subPathHits;
+            return true;
+        }
+    }
+
+    ++stats.misses;
+    return false;
+}
+
+void PathCache::store(int start, int goal, uint32_t flags, uint64_t version, std::vector<int> cells)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!syncVersion(version)) return;
+
+    Key key{start, goal, flags};
+    auto found = index.find(key);
+    if (found != index.end()) evict(found->second);
+
+    size_t bytes = sizeof(Entry) + cells.size() * sizeof(int);
+    if (bytes > budget) return;
+    while (stats.bytes + bytes > budget && !lru.empty()) {
+        evict(std::prev(lru.end()));
+        ++stats.evictions;
+    }
+
+    lru.push_front({key, std::move(cells), bytes});
+    index[key] = lru.begin();
+    if (!lru.front().cells.empty()) byGoal[goalKey(goal, flags)].push_back(lru.begin());
+    stats.bytes += bytes;
+    stats.entries = lru.size();
+}
+
+void PathCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    dropEntries();
+}
+
+PathCache::Stats PathCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void PathCache::dropEntries()
+{
+    lru.clear();
+    index.clear();
+    byGoal.clear();
+    stats.bytes = 0;
+    stats.entries = 0;
+}
+
+bool PathCache::syncVersion(uint64_t version)
+{
+    if (version < currentVersion) return false;
+    if (version > currentVersion) {
+        dropEntries();
+        currentVersion = version;
+    }
+    return true;
+}
+
+void PathCache::evict(EntryList::iterator it)
+{
+    auto sameGoal = byGoal.find(goalKey(it->key.goal, it->key.flags));
+    if (sameGoal != byGoal.end()) {
+        auto &list = sameGoal->second;
+        list.erase(std::remove(list.begin(), list.end(), it), list.end());
+        if (list.empty()) byGoal.erase(sameGoal);
+    }
+    index.erase(it->key);
+    stats.bytes -= it->bytes;
+    lru.erase(it);
+    stats.entries = lru.size();
+}
@@ -0,0 +1,82 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief LRU cache of path query results, keyed by (start, goal, query flags, blocker version).
+ *
+ * Routes are stored as cell lists so that a query whose start lies on a cached route
+ * toward the same goal is answered with that route's suffix. Entries for an older
+ * blocker version can never be hit again, so they are dropped as soon as the
+ * version moves. Memory is bounded by a byte budget; least recently used routes go first.
+ *
+ * One cache is shared by a level's grid and its worker copies (see PathPlanningService), so
+ * every call locks. Versions only move forward: a worker still searching an older blocker
+ * snapshot neither hits nor evicts the newer entries.
+ */
+class PathCache {
+public:
+    static constexpr size_t defaultBudgetBytes = 4 * 1024 * 1024;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t subPathHits = 0; // served from the tail of a longer cached route
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    explicit PathCache(size_t budgetBytes = defaultBudgetBytes) : budget(budgetBytes) {}
+
+    // Cells from start to goal (both included; empty if known unreachable). False on a miss.
+    bool lookup(int start, int goal, uint32_t flags, uint64_t version, std::vector<int> &cells);
+    void store(int start, int goal, uint32_t flags, uint64_t version, std::vector<int> cells);
+    void clear();
+
+    Stats getStats() const;
+
+private:
+    struct Key {
+        int start;
+        int goal;
+        uint32_t flags;
+        bool operator==(const Key &other) const { return start == other.start && goal == other.goal && flags == other.flags; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key &k) const noexcept {
+            uint64_t h = (static_cast<uint64_t>(static_cast<uint32_t>(k.start)) << 32) ^ static_cast<uint32_t>(k.goal);
+            return std::hash<uint64_t>()(h ^ (static_cast<uint64_t>(k.flags) * 0x9E3779B97F4A7C15ull));
+        }
+    };
+    struct Entry {
+        Key key;
+        std::vector<int> cells;
+        size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    static uint64_t goalKey(int goal, uint32_t flags) noexcept {
+        return (static_cast<uint64_t>(flags) << 32) | static_cast<uint32_t>(goal);
+    }
+    // False if version is older than the cached entries; the call is then a miss
+    bool syncVersion(uint64_t version);
+    void dropEntries();
+    void evict(EntryList::iterator it);
+
+    mutable std::mutex mutex;
+    size_t budget;
+    uint64_t currentVersion = 0;
+    EntryList lru; // most recently used first
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    std::unordered_map<uint64_t, std::vector<EntryList::iterator>> byGoal;
+    Stats stats;
+};
+
+#endif // PATHCACHE_H
@@ -0,0 +1,122 @@
+#include "pathdatabasetool.h"
+#include "compressedpathdatabase.h"
+#include "searchgrid.h"
+#include "world.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr int kCheckQueries = 200;
+
+float pathCost(const SearchGrid &grid, int start, const std::vector<int> &path)
+{
+    int x = grid.xOf(start);
+    int y = grid.yOf(start);
+    float cost = 0.0f;
+    for (int d : path) {
+        x += SearchGrid::dirDx[d];
+        y += SearchGrid::dirDy[d];
+        cost += grid.getStepCost(grid.index(x, y));
+    }
+    return cost;
+}
+
+// Random passable pairs: the table's path must cost what Dijkstra finds (within float noise)
+int countMismatches(SearchGrid &grid, const CompressedPathDatabase &db)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(0, grid.size() - 1);
+    auto stepCost = [&grid](int, int to) { return grid.getStepCost(to); };
+    grid.setOpenListKind(OpenListKind::BinaryHeap);
+
+    int mismatches = 0;
+    for (int q = 0, attempts = 0; q < kCheckQueries && attempts < kCheckQueries * 100; ++attempts) {
+        int a = pick(rng);
+        int b = pick(rng);
+        if (a == b || !grid.isPassable(a) || !grid.isPassable(b)) continue;
+        ++q;
+
+        std::vector<int> expected = grid.aStar(a, b, stepCost, ZeroHeuristic{grid.getCols()});
+        std::vector<int> path;
+        CompressedPathDatabase::Lookup found = db.extractPath(grid, a, b, 0, path);
+        if (expected.empty()) {
+            if (found != CompressedPathDatabase::Lookup::NoPath) ++mismatches;
+            continue;
+        }
+        float want = pathCost(grid, a, expected);
+        if (found != CompressedPathDatabase::Lookup::Found || std::fabs(pathCost(grid, a, path) - want) > 1.0e-4f * std::max(1.0f, want)) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+}
+
+int runPathDatabaseBuild(const QVector<QString> &levelFiles, const QString &outputDir, int maxCells)
+{
+    QTextStream out(stdout);
+    if (!QDir().mkpath(outputDir)) {
+        out << "Cannot create " << outputDir << "\n";
+        return 1;
+    }
+
+    int failures = 0;
+    for (const QString &file : levelFiles) {
+        World w;
+        try {
+            w.createWorld(file, 0, 0);
+        } catch (...) {
+            out << "Skipping " << file << ": failed to create world\n";
+            continue;
+        }
+
+        int rows = w.getRows();
+        int cols = w.getCols();
+        if (static_cast<long long>(rows) * cols > maxCells) {
+            out << "Skipping " << file << " (" << cols << "x" << rows << "): more than " << maxCells << " cells\n";
+            continue;
+        }
+        std::vector<std::unique_ptr<TileWrapper>> tiles;
+        for (auto &t : w.getTiles()) {
+            tiles.push_back(std::make_unique<TileWrapper>(std::move(t)));
+        }
+        SearchGrid grid(tiles, rows, cols);
+
+        out << file << " (" << cols << "x" << rows << ")\n";
+        out.flush();
+        QElapsedTimer timer;
+        timer.start();
+        int lastPercent = -1;
+        CompressedPathDatabase db(grid, [&](int done, int total) {
+            int percent = static_cast<int>(100LL * done / std::max(1, total));
+            if (percent / 10 != lastPercent / 10) {
+                out << "  " << percent << "%\n";
+                out.flush();
+                lastPercent = percent;
+            }
+        });
+        out << QString("  built in %1 s: %2 runs, %3 KB (%4 bytes per cell)\n")
+                   .arg(timer.elapsed() / 1000.0, 0, 'f', 1).arg(db.getRunCount())
+                   .arg(db.getMemoryBytes() / 1024).arg(double(db.getMemoryBytes()) / std::max(1, grid.size()), 0, 'f', 1);
+
+        QString target = CompressedPathDatabase::fileFor(file, outputDir);
+        std::shared_ptr<const CompressedPathDatabase> saved;
+        if (db.save(target)) saved = CompressedPathDatabase::load(target, grid);
+        if (!saved) {
+            out << "  failed to write " << target << "\n";
+            ++failures;
+            continue;
+        }
+        int mismatches = countMismatches(grid, *saved);
+        out << "  wrote " << target << ", " << mismatches << "/" << kCheckQueries << " check queries differ from Dijkstra\n";
+        out.flush();
+        if (mismatches > 0) ++failures;
+    }
+
+    return failures > 0 ? 1 : 0;
+}
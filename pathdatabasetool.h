@@ -0,0 +1,19 @@
+#ifndef PATHDATABASETOOL_H
+#define PATHDATABASETOOL_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Builds a CompressedPathDatabase for every level image and writes it to outputDir.
+ *
+ * Run with: complete_final_project --build-path-databases [output dir] [max cells]
+ * Levels with more cells than maxCells are skipped (the build is one Dijkstra per cell).
+ * Each table is read back and checked against Dijkstra on random queries before the next
+ * level starts. The output dir defaults to pathdb/ next to the executable, where the game
+ * loads them from; tables written elsewhere must be copied there to be used in game.
+ * Returns the process exit code.
+ */
+int runPathDatabaseBuild(const QVector<QString> &levelFiles, const QString &outputDir, int maxCells);
+
+#endif // PATHDATABASETOOL_H
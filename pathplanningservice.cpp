@@ -0,0 +1,108 @@
+#include "pathplanningservice.h"
+#include <QMetaObject>
+#include <algorithm>
+#include <thread>
+
+PathPlanningService::PathPlanningService(QObject *parent)
+    : QObject(parent)
+{
+    pool.setMaxThreadCount(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+    backgroundPool.setMaxThreadCount(1);
+}
+
+PathPlanningService::~PathPlanningService()
+{
+    cancelAll();
+    pool.waitForDone();
+    backgroundPool.waitForDone();
+}
+
+void PathPlanningService::cancel(Channel channel)
+{
+    if (cancelFlags[channel]) cancelFlags[channel]->store(true);
+    cancelFlags[channel].reset();
+    pending[channel] = false;
+    ++tickets[channel];
+}
+
+void PathPlanningService::cancelAll()
+{
+    for (int c = 0; c < ChannelCount; ++c) {
+        cancel(static_cast<Channel>(c));
+    }
+}
+
+void PathPlanningService::enqueue(Channel channel, const std::shared_ptr<SearchGrid> &grid,
+                                  std::function<void(SearchGrid &)> work, std::function<void()> deliver)
+{
+    cancel(channel);
+    if (!grid) return;
+
+    uint64_t ticket = tickets[channel];
+    auto flag = std::make_shared<std::atomic<bool>>(false);
+    cancelFlags[channel] = flag;
+    pending[channel] = true;
+    std::shared_ptr<const BlockerSnapshot> blockers = snapshotOf(*grid);
+    SearchGrid::WorkerSetup setup = grid->getWorkerSetup();
+
+    QThreadPool &target = channel == BackgroundChannel ? backgroundPool : pool;
+    target.start([this, channel, ticket, grid, flag, blockers, setup, work = std::move(work),
+                  deliver = std::move(deliver)]() {
+        if (flag->load()) return;
+
+        std::unique_ptr<SearchGrid> worker = acquireWorkerGrid(grid, setup);
+        if (worker->getBlockerVersion() != blockers->version) {
+            worker->setBlockers(blockers->bits, blockers->dangerCosts, blockers->dangerCells, blockers->version);
+        }
+        worker->setCancelFlag(flag.get());
+        work(*worker);
+        worker->setCancelFlag(nullptr);
+        releaseWorkerGrid(grid, std::move(worker));
+
+        if (flag->load()) return;
+        QMetaObject::invokeMethod(this, [this, channel, ticket, deliver]() {
+            // A newer request may have been submitted while this one was running
+            if (tickets[channel] != ticket) return;
+            pending[channel] = false;
+            cancelFlags[channel].reset();
+            deliver();
+        }, Qt::QueuedConnection);
+    });
+}
+
+std::shared_ptr<const PathPlanningService::BlockerSnapshot> PathPlanningService::snapshotOf(const SearchGrid &grid)
+{
+    // Blocker versions are unique across grids, so the version alone identifies the snapshot
+    if (!snapshot || snapshot->version != grid.getBlockerVersion()) {
+        snapshot = std::make_shared<const BlockerSnapshot>(BlockerSnapshot{grid.getBlockerVersion(), grid.getBlockers(),
+                                                                            grid.getDangerStepCosts(), grid.getDangerCellCount()});
+    }
+    return snapshot;
+}
+
+std::unique_ptr<SearchGrid> PathPlanningService::acquireWorkerGrid(const std::shared_ptr<SearchGrid> &grid,
+                                                                   const SearchGrid::WorkerSetup &setup)
+{
+    {
+        std::lock_guard<std::mutex> lock(workerMutex);
+        if (workerSource != grid) {
+            // New level: copies of the old one are useless
+            workerSource = grid;
+            idleWorkers.clear();
+        }
+        if (!idleWorkers.empty()) {
+            std::unique_ptr<SearchGrid> worker = std::move(idleWorkers.back());
+            idleWorkers.pop_back();
+            // Tables may have been built (or the open list switched) since this copy last ran
+            worker->applyWorkerSetup(setup);
+            return worker;
+        }
+    }
+    return grid->cloneForWorker(setup);
+}
+
+void PathPlanningService::releaseWorkerGrid(const std::shared_ptr<SearchGrid> &grid, std::unique_ptr<SearchGrid> worker)
+{
+    std::lock_guard<std::mutex> lock(workerMutex);
+    if (workerSource == grid) idleWorkers.push_back(std::move(worker));
+}
@@ -0,0 +1,83 @@
+#ifndef PATHPLANNINGSERVICE_H
+#define PATHPLANNINGSERVICE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include "searchgrid.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Runs path planning on a worker pool and hands results back on the GUI thread.
+ *
+ * Every worker plans on its own SearchGrid copy (same step costs, its own workspaces and
+ * path cache), loaded with a blocker snapshot and the level tables taken on the GUI thread
+ * when the request was submitted, so the live grid is never read off the GUI thread. Requests are
+ * grouped in channels: a new request on a channel supersedes the previous one, whose
+ * search is cancelled and whose result is never delivered. Background jobs (whole-level
+ * precomputation) run on a separate single-thread pool so they never delay a route.
+ */
+class PathPlanningService : public QObject {
+    Q_OBJECT
+
+public:
+    // AutoPlayRouteChannel carries the whole-level route, so step decisions don't cancel it
+    // CommandSeedChannel builds the command path's repair tree without holding up its walk
+    enum Channel { CommandChannel, CommandSeedChannel, AutoPlayChannel, AutoPlayRouteChannel, PreviewChannel,
+                   BackgroundChannel, ChannelCount };
+
+    explicit PathPlanningService(QObject *parent = nullptr);
+    ~PathPlanningService();
+
+    /**
+     * @brief Runs job on a worker copy of grid, then calls done with its result on the GUI thread.
+     * Must be called on the GUI thread. done is skipped if the request is cancelled or superseded.
+     */
+    template <typename Result>
+    void submit(Channel channel, const std::shared_ptr<SearchGrid> &grid,
+                std::function<Result(SearchGrid &)> job, std::function<void(Result)> done)
+    {
+        auto result = std::make_shared<Result>();
+        enqueue(channel, grid,
+                [job, result](SearchGrid &worker) { *result = job(worker); },
+                [done, result]() { done(std::move(*result)); });
+    }
+
+    void cancel(Channel channel);
+    void cancelAll();
+    bool isPending(Channel channel) const { return pending[channel]; }
+
+private:
+    struct BlockerSnapshot {
+        uint64_t version;
+        std::vector<uint8_t> bits;
+        std::shared_ptr<const std::vector<float>> dangerCosts; // shared with the grid until it writes
+        size_t dangerCells;
+    };
+
+    void enqueue(Channel channel, const std::shared_ptr<SearchGrid> &grid,
+                 std::function<void(SearchGrid &)> work, std::function<void()> deliver);
+    std::shared_ptr<const BlockerSnapshot> snapshotOf(const SearchGrid &grid);
+    std::unique_ptr<SearchGrid> acquireWorkerGrid(const std::shared_ptr<SearchGrid> &grid,
+                                                  const SearchGrid::WorkerSetup &setup);
+    void releaseWorkerGrid(const std::shared_ptr<SearchGrid> &grid, std::unique_ptr<SearchGrid> worker);
+
+    QThreadPool pool;
+    QThreadPool backgroundPool;
+
+    // GUI thread only
+    uint64_t tickets[ChannelCount] = {};
+    bool pending[ChannelCount] = {};
+    std::shared_ptr<std::atomic<bool>> cancelFlags[ChannelCount];
+    std::shared_ptr<const BlockerSnapshot> snapshot; // reused until the blocker version moves
+
+    // Shared with workers: idle grid copies of the level they were cloned from
+    std::mutex workerMutex;
+    std::shared_ptr<SearchGrid> workerSource;
+    std::vector<std::unique_ptr<SearchGrid>> idleWorkers;
+};
+
+#endif // PATHPLANNINGSERVICE_H
@@ -0,0 +1,69 @@
+#include "poidistancematrix.h"
+#include "distancemap.h"
+
+PoiDistanceMatrix::PoiDistanceMatrix(std::vector<Poi> p, uint8_t mask)
+    : pois(std::move(p)), rowState(new std::atomic<uint8_t>[pois.size()]), blockerMask(mask)
+{
+    dist.assign(pois.size() * pois.size(), unknown);
+    for (size_t i = 0; i < pois.size(); ++i) {
+        poiIndex.emplace(pois[i].cell, static_cast<int>(i));
+        rowState[i].store(Pending, std::memory_order_relaxed);
+    }
+}
+
+void PoiDistanceMatrix::compute(const SearchGrid &grid, const std::function<void(int, int)> &onRow)
+{
+    std::vector<int> targets;
+    for (const Poi &poi : pois) targets.push_back(poi.cell);
+
+    DistanceMap flood;
+    int n = getRowCount();
+    for (int i = 0; i < n; ++i) {
+        // Already gone before we got to it
+        if (rowState[i].load(std::memory_order_acquire) == Pending) {
+            flood.compute(grid, pois[i].cell, targets, blockerMask);
+            if (grid.isCancelled()) return;
+
+            float *row = &dist[static_cast<size_t>(i) * n];
+            for (int j = 0; j < n; ++j) {
+                row[j] = pois[j].cell == pois[i].cell ? 0.0f : flood.distanceTo(pois[j].cell);
+            }
+            // An invalidation that came in meanwhile wins
+            uint8_t expected = Pending;
+            rowState[i].compare_exchange_strong(expected, Ready, std::memory_order_release);
+        }
+        int done = rowsDone.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (onRow) onRow(done, n);
+    }
+}
+
+int PoiDistanceMatrix::poiAt(int cell) const noexcept
+{
+    auto it = poiIndex.find(cell);
+    return it == poiIndex.end() ? -1 : it->second;
+}
+
+float PoiDistanceMatrix::distance(int fromCell, int toCell) const noexcept
+{
+    int from = poiAt(fromCell);
+    int to = poiAt(toCell);
+    if (from < 0 || to < 0) return unknown;
+    if (rowState[from].load(std::memory_order_acquire) != Ready) return unknown;
+    if (rowState[to].load(std::memory_order_relaxed) == Invalid) return unknown;
+    return dist[static_cast<size_t>(from) * pois.size() + to];
+}
+
+void PoiDistanceMatrix::invalidateCell(int cell)
+{
+    for (size_t i = 0; i < pois.size(); ++i) {
+        if (pois[i].cell == cell) rowState[i].store(Invalid, std::memory_order_relaxed);
+    }
+}
+
+int PoiDistanceMatrix::getStartCell() const noexcept
+{
+    for (const Poi &poi : pois) {
+        if (poi.kind == Kind::Start) return poi.cell;
+    }
+    return -1;
+}
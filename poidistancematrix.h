@@ -0,0 +1,69 @@
+#ifndef POIDISTANCEMATRIX_H
+#define POIDISTANCEMATRIX_H
+
+#include "searchgrid.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Path costs between every pair of a level's points of interest, filled in on a worker.
+ *
+ * The POIs are the protagonist's start, the enemies, the health packs and the portals as
+ * they were when the level loaded. compute() runs one Dijkstra flood per POI (a row of
+ * the matrix) on a worker grid and publishes each row as soon as it is done, so queries
+ * answer in O(1) from whatever is ready while the rest is still being computed.
+ *
+ * When a POI disappears (a health pack picked up, an enemy defeated or teleported away)
+ * its row and column are invalidated rather than recomputed. distance() may be called
+ * from any thread; invalidateCell() from the GUI thread only.
+ */
+class PoiDistanceMatrix {
+public:
+    enum class Kind { Start, Enemy, HealthPack, Portal };
+    struct Poi {
+        Kind kind;
+        int cell;
+    };
+
+    // Returned by distance() when the answer is not (or no longer) known.
+    static constexpr float unknown = -1.0f;
+
+    // Paths avoid cells whose blocker flags intersect blockerMask (POI cells themselves may be entered).
+    PoiDistanceMatrix(std::vector<Poi> pois, uint8_t blockerMask);
+
+    /**
+     * @brief Fills every row not yet invalidated; called once, on a worker.
+     * Stops early when grid's cancel flag is set. onRow(rowsDone, rowCount) runs on the worker after each row.
+     */
+    void compute(const SearchGrid &grid, const std::function<void(int, int)> &onRow = {});
+
+    // Path cost between two POI cells: infinity if unreachable, unknown if not computed or invalidated.
+    float distance(int fromCell, int toCell) const noexcept;
+    // The POI on this cell is gone.
+    void invalidateCell(int cell);
+
+    const std::vector<Poi>& getPois() const noexcept { return pois; }
+    int getStartCell() const noexcept;
+    uint8_t getBlockerMask() const noexcept { return blockerMask; }
+    int getRowCount() const noexcept { return static_cast<int>(pois.size()); }
+    int getRowsDone() const noexcept { return rowsDone.load(std::memory_order_relaxed); }
+    bool isComplete() const noexcept { return getRowsDone() == getRowCount(); }
+
+private:
+    enum RowState : uint8_t { Pending, Ready, Invalid };
+
+    int poiAt(int cell) const noexcept;
+
+    std::vector<Poi> pois;
+    std::unordered_map<int, int> poiIndex; // cell -> first POI on it
+    std::vector<float> dist;               // row-major, row i only valid once rowState[i] is Ready
+    std::unique_ptr<std::atomic<uint8_t>[]> rowState;
+    std::atomic<int> rowsDone{0};
+    uint8_t blockerMask;
+};
+
+#endif // POIDISTANCEMATRIX_H
@@ -0,0 +1,175 @@
+#include "portalgraph.h"
+#include "distancemap.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace {
+
+// Dijkstra node: standing on a cell of a level (the start or an arrival tile), or at one of its portals
+uint64_t keyOf(int level, int cell, bool atPortal)
+{
+    return (static_cast<uint64_t>(level) << 33) | (static_cast<uint64_t>(cell) << 1) | (atPortal ? 1u : 0u);
+}
+
+constexpr uint64_t kGoalKey = ~uint64_t(0);
+
+}
+
+void PortalGraph::clear()
+{
+    levels.clear();
+}
+
+void PortalGraph::setLevel(int level, std::shared_ptr<const SearchGrid> grid, std::vector<Link> portals, bool cleared)
+{
+    Level &l = levels[level];
+    l.grid = std::move(grid);
+    l.portals = std::move(portals);
+    l.cleared = cleared;
+    l.fromArrival.clear();
+}
+
+void PortalGraph::setCleared(int level, bool cleared)
+{
+    auto it = levels.find(level);
+    if (it != levels.end()) it->second.cleared = cleared;
+}
+
+void PortalGraph::build()
+{
+    for (auto &[from, level] : levels) {
+        for (const Link &link : level.portals) {
+            auto target = levels.find(link.targetLevel);
+            if (target == levels.end()) continue;
+            Level &arrival = target->second;
+            if (link.targetCell < 0 || link.targetCell >= arrival.grid->size()) continue;
+            if (arrival.fromArrival.count(link.targetCell)) continue;
+            // Enemies are gone by the time anyone leaves a level, so walls are all that matter
+            arrival.fromArrival[link.targetCell] = walkToPortals(*arrival.grid, link.targetCell, arrival.portals, 0);
+        }
+    }
+}
+
+float PortalGraph::stepOffAndBack(const SearchGrid &grid, int cell)
+{
+    float best = std::numeric_limits<float>::infinity();
+    for (int d = 0; d < 8; ++d) {
+        int nx = grid.xOf(cell) + SearchGrid::dirDx[d];
+        int ny = grid.yOf(cell) + SearchGrid::dirDy[d];
+        if (grid.inBounds(nx, ny)) best = std::min(best, grid.getStepCost(grid.index(nx, ny)));
+    }
+    return best + grid.getStepCost(cell);
+}
+
+std::vector<float> PortalGraph::walkToPortals(const SearchGrid &grid, int from, const std::vector<Link> &portals,
+                                              uint8_t blockerMask)
+{
+    std::vector<int> targets;
+    for (const Link &link : portals) {
+        if (link.cell != from) targets.push_back(link.cell);
+    }
+    DistanceMap distances;
+    distances.compute(grid, from, targets, blockerMask);
+
+    std::vector<float> result;
+    result.reserve(portals.size());
+    for (const Link &link : portals) {
+        result.push_back(link.cell == from ? stepOffAndBack(grid, from) : distances.distanceTo(link.cell));
+    }
+    return result;
+}
+
+PortalGraph::Route PortalGraph::findRoute(int level, const SearchGrid &grid, int start, uint8_t blockerMask,
+                                          int goalLevel, int goalCell, bool throughUncleared) const
+{
+    Route route;
+    auto startLevel = levels.find(level);
+    auto endLevel = levels.find(goalLevel);
+    if (startLevel == levels.end() || endLevel == levels.end() || start < 0 || start >= grid.size()) return route;
+    if (goalCell >= endLevel->second.grid->size()) return route;
+
+    struct Step {
+        uint64_t from;
+        Leg leg;      // level -1 for a portal hop, -2 for a goal reached without walking
+    };
+    std::unordered_map<uint64_t, float> best;
+    std::unordered_map<uint64_t, Step> parent;
+    using Entry = std::pair<float, uint64_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+    auto relax = [&](uint64_t from, uint64_t to, float cost, Leg leg) {
+        auto it = best.find(to);
+        if (it != best.end() && it->second <= cost) return;
+        best[to] = cost;
+        parent[to] = {from, leg};
+        open.push({cost, to});
+    };
+
+    // Walks out of the start use the live grid; every other walk is walls only
+    auto walkFrom = [&](uint64_t key, float cost, int lvl, int cell, const Level &l, const std::vector<float> &toPortals,
+                        const SearchGrid &walkGrid, uint8_t mask) {
+        for (size_t i = 0; i < l.portals.size(); ++i) {
+            if (toPortals[i] != std::numeric_limits<float>::infinity()) {
+                relax(key, keyOf(lvl, l.portals[i].cell, true), cost + toPortals[i], {lvl, cell, l.portals[i].cell});
+            }
+        }
+        if (lvl != goalLevel) return;
+        if (goalCell < 0 || goalCell == cell) {
+            relax(key, kGoalKey, cost, {-2, cell, cell});
+            return;
+        }
+        DistanceMap distances;
+        distances.compute(walkGrid, cell, {goalCell}, mask);
+        float d = distances.distanceTo(goalCell);
+        if (d != std::numeric_limits<float>::infinity()) relax(key, kGoalKey, cost + d, {lvl, cell, goalCell});
+    };
+
+    uint64_t startKey = keyOf(level, start, false);
+    best[startKey] = 0.0f;
+    open.push({0.0f, startKey});
+
+    while (!open.empty()) {
+        auto [cost, key] = open.top();
+        open.pop();
+        if (cost > best[key]) continue;
+        if (key == kGoalKey) break;
+
+        int lvl = static_cast<int>(key >> 33);
+        int cell = static_cast<int>((key >> 1) & 0xffffffffu);
+        const Level &l = levels.at(lvl);
+
+        if (!(key & 1u)) {
+            if (key == startKey) {
+                walkFrom(key, cost, lvl, cell, l, walkToPortals(grid, cell, l.portals, blockerMask), grid, blockerMask);
+            } else {
+                auto arrival = l.fromArrival.find(cell);
+                if (arrival != l.fromArrival.end()) walkFrom(key, cost, lvl, cell, l, arrival->second, *l.grid, 0);
+            }
+            continue;
+        }
+
+        // At a portal: through it, if its level allows
+        if (!l.cleared && !throughUncleared) continue;
+        for (const Link &link : l.portals) {
+            if (link.cell != cell || link.targetCell < 0 || !levels.count(link.targetLevel)) continue;
+            relax(key, keyOf(link.targetLevel, link.targetCell, false), cost, {-1, cell, link.targetCell});
+        }
+    }
+
+    auto goal = best.find(kGoalKey);
+    if (goal == best.end()) return route;
+    route.cost = goal->second;
+    for (uint64_t key = kGoalKey; key != startKey; key = parent.at(key).from) {
+        const Step &step = parent.at(key);
+        if (step.leg.level >= 0) {
+            route.legs.push_back(step.leg);
+        } else if (step.leg.level == -1) {
+            int left = static_cast<int>(step.from >> 33);
+            if (!levels.at(left).cleared) route.levelsToClear.push_back(left);
+        }
+    }
+    std::reverse(route.legs.begin(), route.legs.end());
+    std::reverse(route.levelsToClear.begin(), route.levelsToClear.end());
+    return route;
+}
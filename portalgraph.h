@@ -0,0 +1,79 @@
+#ifndef PORTALGRAPH_H
+#define PORTALGRAPH_H
+
+#include "searchgrid.h"
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Routes between levels: which portals to take, and the walk on every level in between.
+ *
+ * Each level contributes its portals and a walls-only grid. build() precomputes, per level,
+ * the walking distance from every tile a portal elsewhere drops the protagonist on to every
+ * portal of that level, so a query only floods the level it starts on (with live blockers)
+ * and the goal level once per arrival tile, then runs Dijkstra over portals.
+ *
+ * A portal only works once its level has no living enemies. Routes through uncleared levels
+ * are either rejected or returned with those levels listed, so goto can say which one to clear.
+ */
+class PortalGraph {
+public:
+    struct Link {
+        int cell;
+        int targetLevel;
+        int targetCell;
+    };
+
+    // One walk on one level: from (the start or an arrival tile) to (a portal, or the goal)
+    struct Leg {
+        int level;
+        int from;
+        int to;
+    };
+
+    struct Route {
+        std::vector<Leg> legs;
+        float cost = std::numeric_limits<float>::infinity();
+        std::vector<int> levelsToClear; // levels left through a portal while their enemies live
+        bool found() const { return cost != std::numeric_limits<float>::infinity(); }
+    };
+
+    void clear();
+    // Adds or replaces a level; its precomputed walks are dropped until the next build()
+    void setLevel(int level, std::shared_ptr<const SearchGrid> grid, std::vector<Link> portals, bool cleared);
+    void setCleared(int level, bool cleared);
+    bool hasLevel(int level) const { return levels.count(level) > 0; }
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+    // Walking distance from every arrival tile to every portal on its level
+    void build();
+
+    /**
+     * @brief Cheapest portal route from start on level (searched on grid, the live level, with
+     * blockerMask) to goalCell on goalLevel; goalCell -1 means arriving anywhere on goalLevel.
+     * Without throughUncleared, portals on levels with living enemies are never taken.
+     */
+    Route findRoute(int level, const SearchGrid &grid, int start, uint8_t blockerMask,
+                    int goalLevel, int goalCell, bool throughUncleared) const;
+
+private:
+    struct Level {
+        std::shared_ptr<const SearchGrid> grid;
+        std::vector<Link> portals;
+        bool cleared = false;
+        std::unordered_map<int, std::vector<float>> fromArrival; // arrival cell -> distance to each portal
+    };
+
+    // Walking onto a portal the protagonist already stands on: off to the cheapest neighbour and back
+    static float stepOffAndBack(const SearchGrid &grid, int cell);
+    static std::vector<float> walkToPortals(const SearchGrid &grid, int from, const std::vector<Link> &portals,
+                                            uint8_t blockerMask);
+
+    std::map<int, Level> levels;
+};
+
+#endif // PORTALGRAPH_H
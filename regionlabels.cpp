@@ -0,0 +1,211 @@
+#include "regionlabels.h"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+
+namespace {
+// Path halving; only ever called on cells of the caller's own band until the border merge
+int findRoot(std::vector<int> &parent, int cell)
+{
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]];
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+void unite(std::vector<int> &parent, std::vector<uint8_t> &rank, int a, int b)
+{
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a == b) return;
+    if (rank[a] < rank[b]) std::swap(a, b);
+    parent[b] = a;
+    if (rank[a] == rank[b]) ++rank[a];
+}
+}
+
+RegionLabels::RegionLabels(const SearchGrid &grid, uint8_t blockerMask, unsigned threadCount)
+    : regionCount(0), mask(blockerMask), blockerVersion(grid.getBlockerVersion())
+{
+    int rows = grid.getRows();
+    int cols = grid.getCols();
+    int cells = grid.size();
+    labels.assign(cells, noRegion);
+    if (cells == 0) return;
+
+    auto open = [this, &grid](int cell) { return this->open(grid, cell); };
+
+    std::vector<int> parent(cells);
+    std::vector<uint8_t> rank(cells, 0);
+    for (int i = 0; i < cells; ++i) parent[i] = i;
+
+    // Each band only links cells to their left and upper neighbours inside the band
+    auto linkRow = [&](int y, bool withRowAbove) {
+        for (int x = 0; x < cols; ++x) {
+            int cell = grid.index(x, y);
+            if (!open(cell)) continue;
+            if (x > 0 && open(cell - 1)) unite(parent, rank, cell, cell - 1);
+            if (!withRowAbove) continue;
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (x + dx < 0 || x + dx >= cols) continue;
+                int above = grid.index(x + dx, y - 1);
+                if (open(above)) unite(parent, rank, cell, above);
+            }
+        }
+    };
+
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    int bandCount = static_cast<int>(std::min<unsigned>(std::max(1u, threadCount), static_cast<unsigned>(rows)));
+    int bandHeight = (rows + bandCount - 1) / bandCount;
+    auto band = [&](int b) {
+        int first = b * bandHeight;
+        int last = std::min(rows, first + bandHeight);
+        for (int y = first; y < last; ++y) linkRow(y, y > first);
+    };
+
+    std::vector<std::thread> threads;
+    for (int b = 1; b < bandCount; ++b) {
+        threads.emplace_back(band, b);
+    }
+    band(0);
+    for (auto &t : threads) t.join();
+
+    // Stitch each band to the one above it
+    for (int y = bandHeight; y < rows; y += bandHeight) {
+        for (int x = 0; x < cols; ++x) {
+            int cell = grid.index(x, y);
+            if (!open(cell)) continue;
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (x + dx < 0 || x + dx >= cols) continue;
+                int above = grid.index(x + dx, y - 1);
+                if (open(above)) unite(parent, rank, cell, above);
+            }
+        }
+    }
+
+    // Dense labels in row-major order of each region's first cell
+    std::vector<int> rootLabel(cells, noRegion);
+    for (int cell = 0; cell < cells; ++cell) {
+        if (!open(cell)) continue;
+        int root = findRoot(parent, cell);
+        if (rootLabel[root] == noRegion) rootLabel[root] = regionCount++;
+        labels[cell] = rootLabel[root];
+    }
+}
+
+void RegionLabels::update(const SearchGrid &grid, const std::vector<int> &changedCells)
+{
+    blockerVersion = grid.getBlockerVersion();
+    auto forNeighbours = [&grid](int cell, auto &&visit) {
+        for (int d = 0; d < 8; ++d) {
+            int nx = grid.xOf(cell) + SearchGrid::dirDx[d];
+            int ny = grid.yOf(cell) + SearchGrid::dirDy[d];
+            if (grid.inBounds(nx, ny)) visit(grid.index(nx, ny));
+        }
+    };
+
+    // Cells that actually opened or closed under this mask
+    std::vector<int> toggled;
+    for (int cell : changedCells) {
+        if ((labels[cell] != noRegion) != open(grid, cell)) toggled.push_back(cell);
+    }
+    if (toggled.empty()) return;
+    std::sort(toggled.begin(), toggled.end());
+    toggled.erase(std::unique(toggled.begin(), toggled.end()), toggled.end());
+    auto isToggled = [&toggled](int cell) { return std::binary_search(toggled.begin(), toggled.end(), cell); };
+
+    // A lone change is usually settled by its 3x3 neighbourhood: a closed cell whose open
+    // neighbours still touch each other splits nothing, an opened cell next to a single
+    // region just joins it. Everything else floods the regions around the change.
+    std::vector<int> seeds;
+    std::vector<int> joined;
+    for (int cell : toggled) {
+        bool opened = open(grid, cell);
+        bool local = true;
+        forNeighbours(cell, [&](int n) { if (isToggled(n)) local = false; });
+        if (local && opened) {
+            int label = noRegion;
+            forNeighbours(cell, [&](int n) {
+                if (!open(grid, n)) return;
+                if (label == noRegion) label = labels[n];
+                else if (labels[n] != label) local = false;
+            });
+        } else if (local) {
+            local = ringConnected(grid, cell);
+        }
+        if (!opened) labels[cell] = noRegion;
+        if (local) {
+            if (opened) joined.push_back(cell);
+            continue;
+        }
+        if (opened) seeds.push_back(cell);
+        forNeighbours(cell, [&](int n) { if (open(grid, n)) seeds.push_back(n); });
+    }
+
+    // Every region touching a seed gets a fresh label; regions away from the changes keep theirs
+    int firstFresh = regionCount;
+    for (int seed : seeds) {
+        if (labels[seed] == noRegion || labels[seed] < firstFresh) flood(grid, seed, regionCount++);
+    }
+    for (int cell : joined) {
+        if (labels[cell] != noRegion) continue; // reached by a flood
+        forNeighbours(cell, [&](int n) {
+            if (labels[cell] == noRegion && open(grid, n)) labels[cell] = labels[n];
+        });
+        if (labels[cell] == noRegion) labels[cell] = regionCount++;
+    }
+}
+
+bool RegionLabels::ringConnected(const SearchGrid &grid, int cell) const
+{
+    // Open neighbours of cell, linked when they are neighbours of each other
+    int parent[8];
+    bool ring[8];
+    for (int d = 0; d < 8; ++d) {
+        int nx = grid.xOf(cell) + SearchGrid::dirDx[d];
+        int ny = grid.yOf(cell) + SearchGrid::dirDy[d];
+        ring[d] = grid.inBounds(nx, ny) && open(grid, grid.index(nx, ny));
+        parent[d] = d;
+    }
+    auto root = [&parent](int d) {
+        while (parent[d] != d) d = parent[d];
+        return d;
+    };
+    int groups = 0;
+    for (int a = 0; a < 8; ++a) {
+        if (!ring[a]) continue;
+        ++groups;
+        for (int b = 0; b < a; ++b) {
+            if (!ring[b] || std::abs(SearchGrid::dirDx[a] - SearchGrid::dirDx[b]) > 1
+                || std::abs(SearchGrid::dirDy[a] - SearchGrid::dirDy[b]) > 1) continue;
+            int ra = root(a);
+            int rb = root(b);
+            if (ra != rb) {
+                parent[ra] = rb;
+                --groups;
+            }
+        }
+    }
+    return groups <= 1;
+}
+
+void RegionLabels::flood(const SearchGrid &grid, int seed, int label)
+{
+    std::vector<int> stack{seed};
+    labels[seed] = label;
+    while (!stack.empty()) {
+        int cell = stack.back();
+        stack.pop_back();
+        for (int d = 0; d < 8; ++d) {
+            int nx = grid.xOf(cell) + SearchGrid::dirDx[d];
+            int ny = grid.yOf(cell) + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+            int next = grid.index(nx, ny);
+            if (labels[next] == label || !open(grid, next)) continue;
+            labels[next] = label;
+            stack.push_back(next);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef REGIONLABELS_H
+#define REGIONLABELS_H
+
+#include "searchgrid.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Connected-component labels of a level: two cells share a label exactly when a path
+ *        exists between them, so unreachable goals are rejected without searching.
+ *
+ * Built with a union-find over bands of rows (one thread per band), then the band borders
+ * are merged and the roots compacted into dense labels. With a blocker mask, cells blocked
+ * by it count as walls; SearchGrid::canReach keeps one such labelling per mask and patches
+ * it with update() from the cells whose blockers changed. The mask-free labels depend on
+ * tiles only and are kept in the CachedLevel like the landmark tables.
+ */
+class RegionLabels {
+public:
+    static constexpr int noRegion = -1;
+
+    // threadCount 0 uses one band per hardware thread
+    explicit RegionLabels(const SearchGrid &grid, uint8_t blockerMask = 0, unsigned threadCount = 0);
+
+    /**
+     * @brief Brings the labels up to the grid's current blockers, given every cell whose blocker
+     *        bits changed since they were built. Only regions next to those cells are relabelled.
+     */
+    void update(const SearchGrid &grid, const std::vector<int> &changedCells);
+
+    // noRegion for walls (and for cells blocked by the mask).
+    int regionOf(int cell) const noexcept { return labels[cell]; }
+    bool connected(int a, int b) const noexcept { return labels[a] != noRegion && labels[a] == labels[b]; }
+    // Labels handed out so far; after update() some of them may no longer be in use
+    int getRegionCount() const noexcept { return regionCount; }
+
+    uint8_t getBlockerMask() const noexcept { return mask; }
+    uint64_t getBlockerVersion() const noexcept { return blockerVersion; }
+
+private:
+    bool open(const SearchGrid &grid, int cell) const noexcept
+    {
+        return grid.isPassable(cell) && !grid.isBlocked(cell, mask);
+    }
+    bool ringConnected(const SearchGrid &grid, int cell) const;
+    void flood(const SearchGrid &grid, int seed, int label);
+
+    std::vector<int> labels;
+    int regionCount;
+    uint8_t mask;
+    uint64_t blockerVersion;
+};
+
+#endif // REGIONLABELS_H
@@ -0,0 +1,130 @@
+#include "resourcesearch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+ResourceSearch::Result ResourceSearch::findPath(const SearchGrid &grid, const Request &request, size_t maxLabels)
+{
+    Result result;
+    labels.clear();
+    labelsAt.clear();
+    open.clear();
+
+    const int start = request.start;
+    const int goal = request.goal;
+    if (start < 0 || start >= grid.size() || goal < 0 || goal >= grid.size() || !grid.isPassable(goal)) return result;
+
+    std::unordered_map<int, int> packAt;
+    for (int i = 0; i < static_cast<int>(request.healthPacks.size()) && i < maxHealthPacks; ++i) {
+        packAt.emplace(request.healthPacks[i].cell, i);
+    }
+
+    // Straight-line lower bound on the energy still needed: consistent, so labels leave the open list cheapest first
+    const float minStep = grid.getMinStepCost();
+    auto heuristic = [&](int cell) {
+        int dx = std::abs(grid.xOf(cell) - grid.xOf(goal));
+        int dy = std::abs(grid.yOf(cell) - grid.yOf(goal));
+        return minStep * static_cast<float>(std::max(dx, dy));
+    };
+    auto greater = std::greater<SearchWorkspace::OpenEntry>();
+    bool energyPruned = false;
+    bool healthPruned = false;
+    bool reached = false;
+
+    insert({0.0f, request.health, 0, start, -1, true});
+    open.push_back({heuristic(start), 0});
+
+    while (!open.empty() && !grid.isCancelled()) {
+        std::pop_heap(open.begin(), open.end(), greater);
+        int index = open.back().index;
+        open.pop_back();
+        // Dominated after it was queued
+        if (!labels[index].alive) continue;
+        const Label current = labels[index];
+
+        if (current.cell == goal && start != goal) {
+            result.status = Status::Found;
+            result.energyLeft = request.energy - current.spent;
+            result.healthLeft = current.health - request.goalDamage;
+            std::vector<int> cells;
+            for (int l = index; l >= 0; l = labels[l].parent) cells.push_back(labels[l].cell);
+            std::reverse(cells.begin(), cells.end());
+            for (size_t i = 1; i < cells.size(); ++i) {
+                result.path.push_back(SearchGrid::directionBetween(grid.xOf(cells[i-1]), grid.yOf(cells[i-1]),
+                                                                   grid.xOf(cells[i]), grid.yOf(cells[i])));
+                if (result.healthPack < 0 && packAt.count(cells[i])) result.healthPack = cells[i];
+            }
+            result.labels = labels.size();
+            return result;
+        }
+
+        int cx = grid.xOf(current.cell);
+        int cy = grid.yOf(current.cell);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + SearchGrid::dirDx[d];
+            int ny = cy + SearchGrid::dirDy[d];
+            if (!grid.inBounds(nx, ny)) continue;
+
+            int next = grid.index(nx, ny);
+            // The budget is energy, so the danger layer an AvoidDanger mask would add is not charged
+            if (next != goal && grid.isBlocked(next, request.blockerMask)) continue;
+            float step = grid.getStepCost(next);
+            if (step == std::numeric_limits<float>::infinity()) continue;
+            if (next == goal) reached = true;
+
+            Label label{current.spent + step, current.health, current.packsUsed, next, index, true};
+            // Energy never comes back: the goal must still be affordable in a straight line
+            if (label.spent + heuristic(next) > request.energy) {
+                energyPruned = true;
+                continue;
+            }
+            auto pack = packAt.find(next);
+            if (pack != packAt.end() && !(label.packsUsed >> pack->second & 1u)) {
+                label.health = std::min(request.maxHealth, label.health + request.healthPacks[pack->second].heal);
+                label.packsUsed |= uint64_t(1) << pack->second;
+            }
+            float needed = next == goal ? request.goalDamage : 0.0f;
+            if (label.health <= needed) {
+                healthPruned = true;
+                continue;
+            }
+
+            if (!insert(label)) continue;
+            if (labels.size() > maxLabels) {
+                result.status = Status::LabelLimit;
+                result.labels = labels.size();
+                return result;
+            }
+            open.push_back({label.spent + heuristic(next), static_cast<int>(labels.size()) - 1});
+            std::push_heap(open.begin(), open.end(), greater);
+        }
+    }
+
+    // Energy is the harder limit: health packs can't fix it
+    if (energyPruned) result.status = Status::OutOfEnergy;
+    else if (healthPruned || reached) result.status = Status::OutOfHealth;
+    result.labels = labels.size();
+    return result;
+}
+
+bool ResourceSearch::insert(const Label &label)
+{
+    std::vector<int> &here = labelsAt[label.cell];
+    for (int other : here) {
+        const Label &o = labels[other];
+        if (o.spent <= label.spent && o.health >= label.health && (o.packsUsed & ~label.packsUsed) == 0) return false;
+    }
+    // Keep only the labels the new one does not dominate
+    here.erase(std::remove_if(here.begin(), here.end(), [&](int other) {
+        Label &o = labels[other];
+        if (label.spent <= o.spent && label.health >= o.health && (label.packsUsed & ~o.packsUsed) == 0) {
+            o.alive = false;
+            return true;
+        }
+        return false;
+    }), here.end());
+    here.push_back(static_cast<int>(labels.size()));
+    labels.push_back(label);
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef RESOURCESEARCH_H
+#define RESOURCESEARCH_H
+
+#include "searchgrid.h"
+#include "searchworkspace.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Resource-constrained shortest paths: the cheapest route the protagonist can actually afford.
+ *
+ * Every step spends the tile's energy cost and energy never comes back, so a route is only
+ * affordable if its cost fits the energy left. Health is only lost at the goal: the fight there,
+ * including a PEnemy's poison, which the game deals to the tile it is defeated on and nowhere
+ * else, so no cell on the way costs health. Health packs on the way restore it first.
+ * The search is a multi-criteria A* over labels (energy spent, health left, health packs
+ * used) instead of cells: a cell keeps every label no other label there dominates (spent no
+ * more, has at least as much health, used no pack the other still has). Labels that can no
+ * longer afford the goal even in a straight line, or whose health drops to zero, are pruned.
+ *
+ * The first feasible label to reach the goal is the cheapest affordable route. It may detour
+ * through health packs when the fight at the goal needs them; the first one is reported.
+ * Without packs there is one label per cell, and this is plain A*.
+ */
+class ResourceSearch {
+public:
+    static constexpr size_t defaultMaxLabels = size_t(1) << 20;
+    // Packs beyond this many are treated as absent (the used set is a 64-bit mask)
+    static constexpr int maxHealthPacks = 64;
+
+    struct HealthPackSite {
+        int cell;
+        float heal;
+    };
+
+    struct Request {
+        int start = -1;
+        int goal = -1;
+        uint8_t blockerMask = 0;    // AvoidDanger is ignored: steps are charged in energy only
+        float energy = 0.0f;        // budget: the route may spend at most this much
+        float health = 0.0f;
+        float maxHealth = 100.0f;
+        float goalDamage = 0.0f;    // health lost on arrival (the fight); must leave some
+        std::vector<HealthPackSite> healthPacks;
+    };
+
+    enum class Status { Found, NoPath, OutOfEnergy, OutOfHealth, LabelLimit };
+
+    struct Result {
+        Status status = Status::NoPath;
+        std::vector<int> path;      // 0-7 directions, only when Found
+        float energyLeft = 0.0f;
+        float healthLeft = 0.0f;    // after the goal's damage
+        int healthPack = -1;        // cell of the first health pack the route picks up
+        size_t labels = 0;          // labels created, for comparing against a plain search
+    };
+
+    Result findPath(const SearchGrid &grid, const Request &request, size_t maxLabels = defaultMaxLabels);
+
+private:
+    struct Label {
+        float spent;
+        float health;
+        uint64_t packsUsed;
+        int cell;
+        int parent;  // label index, -1 at the start
+        bool alive;
+    };
+
+    // Adds the label at its cell unless dominated; drops the labels there it dominates
+    bool insert(const Label &label);
+
+    std::vector<Label> labels;
+    std::unordered_map<int, std::vector<int>> labelsAt; // cell -> live label indices
+    std::vector<SearchWorkspace::OpenEntry> open;       // f = spent + heuristic, index = label
+};
+
+#endif // RESOURCESEARCH_H
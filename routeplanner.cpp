@@ -0,0 +1,207 @@
+#include "routeplanner.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr float kInf = std::numeric_limits<float>::infinity();
+// Added per fight the order cannot survive, so 2-opt always prefers survivable orders
+constexpr float kFatalFightPenalty = 1.0e6f;
+// Above this many enemies 2-opt scores orders by distance only; the health repair runs once at the end
+constexpr int kMaxRepairScoredEnemies = 64;
+constexpr int kMaxTwoOptPasses = 50;
+}
+
+void RoutePlanner::plan(const SearchGrid &grid, int startCell, float health, const std::vector<Stop> &enemies,
+                        const std::vector<Stop> &healthPacks, int portalCell, uint8_t blockerMask,
+                        const PoiDistanceMatrix *known)
+{
+    route.clear();
+    routeCost = 0.0f;
+    startHealth = health;
+    // The order is measured in energy; the danger layer only shapes the legs walked between stops
+    blockerMask &= static_cast<uint8_t>(~SearchGrid::AvoidDanger);
+
+    pois.clear();
+    pois.push_back({Stop::Kind::Portal, startCell, -1, 0.0f}); // node 0: where we stand now
+    pois.insert(pois.end(), enemies.begin(), enemies.end());
+    firstPackNode = static_cast<int>(pois.size());
+    pois.insert(pois.end(), healthPacks.begin(), healthPacks.end());
+    packEndNode = static_cast<int>(pois.size());
+    endNode = -1;
+    if (portalCell >= 0) {
+        endNode = static_cast<int>(pois.size());
+        pois.push_back({Stop::Kind::Portal, portalCell, -1, 0.0f});
+    }
+    nodeCount = static_cast<int>(pois.size());
+
+    // Each flood settles only the POIs after its source; reversing a path swaps which
+    // endpoint's step cost is paid, which gives the other half of the matrix
+    dist.assign(static_cast<size_t>(nodeCount) * nodeCount, kInf);
+    auto setPair = [&](int i, int j, float d) {
+        dist[i*nodeCount + j] = d;
+        if (d != kInf) {
+            dist[j*nodeCount + i] = d - grid.getStepCost(pois[j].cell) + grid.getStepCost(pois[i].cell);
+        }
+    };
+    // Pairs the level's background matrix already has are not flooded again
+    if (known && known->getBlockerMask() != blockerMask) known = nullptr;
+    std::vector<int> targets;
+    std::vector<int> missing;
+    for (int i = 0; i < nodeCount; ++i) {
+        dist[i*nodeCount + i] = 0.0f;
+        targets.clear();
+        missing.clear();
+        for (int j = i + 1; j < nodeCount; ++j) {
+            float d = pois[i].cell == pois[j].cell ? 0.0f : PoiDistanceMatrix::unknown;
+            if (d == PoiDistanceMatrix::unknown && known) d = known->distance(pois[i].cell, pois[j].cell);
+            if (d != PoiDistanceMatrix::unknown) {
+                setPair(i, j, d);
+            } else {
+                targets.push_back(pois[j].cell);
+                missing.push_back(j);
+            }
+        }
+        if (targets.empty()) continue;
+
+        flood.compute(grid, pois[i].cell, targets, blockerMask);
+        for (int j : missing) setPair(i, j, flood.distanceTo(pois[j].cell));
+    }
+
+    if (endNode >= 0 && dist[endNode] == kInf) endNode = -1;
+
+    std::vector<int> enemyNodes;
+    for (int e = 1; e <= static_cast<int>(enemies.size()); ++e) {
+        if (dist[e] != kInf) enemyNodes.push_back(e);
+    }
+
+    std::vector<int> order = nearestInsertion(enemyNodes);
+    twoOpt(order);
+
+    std::vector<int> nodes;
+    routeCost = repair(order, &nodes);
+    for (int node : nodes) route.push_back(pois[node]);
+}
+
+float RoutePlanner::leg(int from, int to) const noexcept
+{
+    return to < 0 ? 0.0f : dist[from*nodeCount + to];
+}
+
+float RoutePlanner::repair(const std::vector<int> &enemyOrder, std::vector<int> *nodes) const
+{
+    std::vector<char> used(nodeCount, 0);
+    float health = startHealth;
+    float cost = 0.0f;
+    int prev = 0;
+
+    for (int e : enemyOrder) {
+        float damage = pois[e].amount;
+        while (health - damage <= 0.0f) {
+            // Cheapest detour through a pack we have not picked up yet
+            int best = -1;
+            float bestDetour = kInf;
+            for (int h = firstPackNode; h < packEndNode; ++h) {
+                if (used[h]) continue;
+                float detour = leg(prev, h) + leg(h, e);
+                if (detour < bestDetour) {
+                    bestDetour = detour;
+                    best = h;
+                }
+            }
+            if (best < 0) break;
+
+            used[best] = 1;
+            cost += leg(prev, best);
+            health = std::min(maxHealth, health + pois[best].amount);
+            prev = best;
+            if (nodes) nodes->push_back(best);
+        }
+        if (health - damage <= 0.0f) cost += kFatalFightPenalty;
+
+        cost += leg(prev, e);
+        health -= damage;
+        prev = e;
+        if (nodes) nodes->push_back(e);
+    }
+
+    cost += leg(prev, endNode);
+    if (nodes && endNode >= 0) nodes->push_back(endNode);
+    return cost;
+}
+
+std::vector<int> RoutePlanner::nearestInsertion(const std::vector<int> &enemyNodes) const
+{
+    std::vector<int> tour{0};
+    if (endNode >= 0) tour.push_back(endNode);
+    std::vector<int> remaining = enemyNodes;
+
+    while (!remaining.empty()) {
+        // Enemy closest to any node already on the tour
+        size_t pick = 0;
+        float pickDist = kInf;
+        for (size_t r = 0; r < remaining.size(); ++r) {
+            for (int t : tour) {
+                float d = leg(t, remaining[r]);
+                if (d < pickDist) {
+                    pickDist = d;
+                    pick = r;
+                }
+            }
+        }
+        int e = remaining[pick];
+        remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(pick));
+
+        // Cheapest place to insert it; the start stays first and the portal last
+        size_t bestPos = tour.size();
+        float bestDelta = kInf;
+        size_t lastPos = endNode >= 0 ? tour.size() - 1 : tour.size();
+        for (size_t pos = 1; pos <= lastPos; ++pos) {
+            float delta = leg(tour[pos-1], e);
+            if (pos < tour.size()) delta += leg(e, tour[pos]) - leg(tour[pos-1], tour[pos]);
+            if (delta < bestDelta) {
+                bestDelta = delta;
+                bestPos = pos;
+            }
+        }
+        tour.insert(tour.begin() + static_cast<std::ptrdiff_t>(bestPos), e);
+    }
+
+    std::vector<int> order(tour.begin() + 1, endNode >= 0 ? tour.end() - 1 : tour.end());
+    return order;
+}
+
+void RoutePlanner::twoOpt(std::vector<int> &order) const
+{
+    if (order.size() < 3) return;
+
+    bool scoreWithHealth = static_cast<int>(order.size()) <= kMaxRepairScoredEnemies;
+    auto score = [this, scoreWithHealth](const std::vector<int> &o) {
+        if (scoreWithHealth) return repair(o, nullptr);
+        float cost = 0.0f;
+        int prev = 0;
+        for (int e : o) {
+            cost += leg(prev, e);
+            prev = e;
+        }
+        return cost + leg(prev, endNode);
+    };
+
+    // Costs are directed (entering a tile is what costs energy), so candidates are scored whole
+    float best = score(order);
+    for (int pass = 0; pass < kMaxTwoOptPasses; ++pass) {
+        bool improved = false;
+        for (size_t i = 0; i + 1 < order.size(); ++i) {
+            for (size_t j = i + 1; j < order.size(); ++j) {
+                std::reverse(order.begin() + static_cast<std::ptrdiff_t>(i), order.begin() + static_cast<std::ptrdiff_t>(j) + 1);
+                float candidate = score(order);
+                if (candidate < best - 1e-6f) {
+                    best = candidate;
+                    improved = true;
+                } else {
+                    std::reverse(order.begin() + static_cast<std::ptrdiff_t>(i), order.begin() + static_cast<std::ptrdiff_t>(j) + 1);
+                }
+            }
+        }
+        if (!improved) break;
+    }
+}
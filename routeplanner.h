@@ -0,0 +1,66 @@
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include "searchgrid.h"
+#include "distancemap.h"
+#include "poidistancematrix.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Orders a whole level for autoplay: every enemy, the health packs needed to survive them, then the portal.
+ *
+ * plan() runs on every autoplay start and builds a POI-to-POI distance matrix for the
+ * current position, with at most one Dijkstra flood per point of interest (each flood
+ * only has to settle the POIs after it; the other half of the matrix follows from
+ * reversing the paths). The enemy order starts from nearest insertion and is improved
+ * with 2-opt, where every candidate order is scored after inserting the cheapest
+ * health-pack detours that keep health above zero at each fight.
+ *
+ * The per-level cache is the level's PoiDistanceMatrix: pairs it already holds (when
+ * passed and measured with the same blocker mask) are looked up instead of flooded, so
+ * once it is complete only the protagonist's own row, and rows invalidated since, cost a
+ * flood. Costs are energy: SearchGrid::AvoidDanger is ignored, so autoplay's danger-aware
+ * mask still matches the level's matrix.
+ */
+class RoutePlanner {
+public:
+    static constexpr float maxHealth = 100.0f;
+
+    struct Stop {
+        enum class Kind { Enemy, HealthPack, Portal };
+        Kind kind;
+        int cell;
+        int id;        // index into the caller's enemy / health pack list
+        float amount;  // damage taken for enemies, health restored for health packs
+    };
+
+    void plan(const SearchGrid &grid, int startCell, float health, const std::vector<Stop> &enemies,
+              const std::vector<Stop> &healthPacks, int portalCell, uint8_t blockerMask,
+              const PoiDistanceMatrix *known = nullptr);
+
+    // Stops in visiting order; enemies that cannot be reached are left out.
+    const std::vector<Stop>& getRoute() const noexcept { return route; }
+    float getRouteCost() const noexcept { return routeCost; }
+
+private:
+    float leg(int from, int to) const noexcept;
+    // Walks an enemy order, inserting health packs where a fight would be fatal; returns the energy spent.
+    float repair(const std::vector<int> &enemyOrder, std::vector<int> *nodes) const;
+    std::vector<int> nearestInsertion(const std::vector<int> &enemyNodes) const;
+    void twoOpt(std::vector<int> &order) const;
+
+    std::vector<Stop> pois;        // node 0 is the start, the last node the portal (if any)
+    std::vector<float> dist;       // row-major node x node path costs
+    int nodeCount = 0;
+    int firstPackNode = 0;         // health packs are nodes [firstPackNode, packEndNode)
+    int packEndNode = 0;
+    int endNode = -1;              // portal node, or -1 when the route ends at the last enemy
+    float startHealth = 0.0f;
+    DistanceMap flood;
+
+    std::vector<Stop> route;
+    float routeCost = 0.0f;
+};
+
+#endif // ROUTEPLANNER_H
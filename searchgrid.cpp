@@ -0,0 +1,342 @@
+#include "searchgrid.h"
+#include "jumppointsearch.h"
+#include "bidirectionalsearch.h"
+#include "focalsearch.h"
+#include "landmarks.h"
+#include "regionlabels.h"
+#include "compressedpathdatabase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Versions are unique across grids, so a cached result can never match a different level's grid
+uint64_t nextBlockerVersion()
+{
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+}
+
+SearchGrid::SearchGrid(const std::vector<std::unique_ptr<TileWrapper>> &tiles, int rows, int cols)
+    : rows(rows), cols(cols), levelId(nextBlockerVersion()), uniformCost(true), minStepCost(0.0f),
+      blockerVersion(nextBlockerVersion()), pathCache(std::make_shared<PathCache>())
+{
+    stepCost.assign(static_cast<size_t>(rows) * cols, std::numeric_limits<float>::infinity());
+    blockers.assign(stepCost.size(), 0);
+
+    float firstCost = std::numeric_limits<float>::infinity();
+    for (auto &tw : tiles) {
+        int x = tw->getXPos();
+        int y = tw->getYPos();
+        if (!inBounds(x, y)) continue;
+        float val = tw->getValue();
+        if (val != std::numeric_limits<float>::infinity()) {
+            float cost = 1.0f/(val+1.0f)*0.1f;
+            stepCost[index(x, y)] = cost;
+            if (firstCost == std::numeric_limits<float>::infinity()) {
+                firstCost = cost;
+                minStepCost = cost;
+            } else if (cost != firstCost) {
+                uniformCost = false;
+                minStepCost = std::min(minStepCost, cost);
+            }
+        }
+    }
+    dangerStepCost = std::make_shared<const std::vector<float>>(stepCost);
+}
+
+SearchGrid::SearchGrid(const SearchGrid &other)
+    : rows(other.rows), cols(other.cols), levelId(other.levelId), stepCost(other.stepCost),
+      uniformCost(other.uniformCost), minStepCost(other.minStepCost), blockerVersion(0), pathCache(other.pathCache)
+{
+    blockers.assign(stepCost.size(), 0);
+    dangerStepCost = std::make_shared<const std::vector<float>>(stepCost);
+}
+
+std::unique_ptr<SearchGrid> SearchGrid::cloneForWorker(const WorkerSetup &setup) const
+{
+    std::unique_ptr<SearchGrid> worker(new SearchGrid(*this));
+    worker->applyWorkerSetup(setup);
+    return worker;
+}
+
+SearchGrid::WorkerSetup SearchGrid::getWorkerSetup() const
+{
+    return {landmarks, regions, pathDatabase, getOpenListKind()};
+}
+
+void SearchGrid::applyWorkerSetup(const WorkerSetup &setup)
+{
+    landmarks = setup.landmarks;
+    pathDatabase = setup.pathDatabase;
+    // Both keep state derived from the old value, so only a real change resets it
+    if (regions != setup.regions) setRegions(setup.regions);
+    if (getOpenListKind() != setup.openListKind) setOpenListKind(setup.openListKind);
+}
+
+void SearchGrid::setBlockers(const std::vector<uint8_t> &bits, std::shared_ptr<const std::vector<float>> dangerCosts,
+                             size_t dangerCellCount, uint64_t version)
+{
+    if (bits.size() != blockers.size() || !dangerCosts || dangerCosts->size() != stepCost.size()) return;
+    // Snapshots may arrive out of order, so the journal records the difference, not the version
+    for (size_t i = 0; i < bits.size(); ++i) {
+        if (bits[i] != blockers[i]) journalBlocker(static_cast<int>(i));
+    }
+    blockers = bits;
+    dangerStepCost = std::move(dangerCosts);
+    dangerCells = dangerCellCount;
+    blockerVersion = version;
+}
+
+std::vector<float>& SearchGrid::writableDanger()
+{
+    // Snapshots (or workers) still read the current layer: write to a private copy
+    if (dangerStepCost.use_count() > 1) {
+        dangerStepCost = std::make_shared<const std::vector<float>>(*dangerStepCost);
+    }
+    // Every layer is created non-const by make_shared, and no one else holds this one
+    return const_cast<std::vector<float>&>(*dangerStepCost);
+}
+
+bool SearchGrid::setDanger(int idx, float extraCost) noexcept
+{
+    // Walls stay infinite either way
+    if (stepCost[idx] == std::numeric_limits<float>::infinity()) return false;
+    float cost = stepCost[idx] + std::max(0.0f, extraCost);
+    if (cost == (*dangerStepCost)[idx]) return false;
+    if ((*dangerStepCost)[idx] == stepCost[idx]) ++dangerCells;
+    else if (cost == stepCost[idx]) --dangerCells;
+    writableDanger()[idx] = cost;
+    blockerVersion = nextBlockerVersion();
+    return true;
+}
+
+void SearchGrid::setDangerLayer(const std::vector<float> &extraCosts)
+{
+    if (extraCosts.size() != stepCost.size()) return;
+    auto layer = std::make_shared<std::vector<float>>(stepCost.size());
+    dangerCells = 0;
+    for (size_t i = 0; i < stepCost.size(); ++i) {
+        (*layer)[i] = stepCost[i] + std::max(0.0f, extraCosts[i]);
+        if ((*layer)[i] != stepCost[i]) ++dangerCells;
+    }
+    dangerStepCost = std::move(layer);
+    blockerVersion = nextBlockerVersion();
+}
+
+void SearchGrid::setOpenListKind(OpenListKind kind)
+{
+    workspace.setOpenListKind(kind);
+    backwardWorkspace.setOpenListKind(kind);
+}
+
+SearchGrid::~SearchGrid() = default;
+
+void SearchGrid::setRegions(std::shared_ptr<const RegionLabels> labels)
+{
+    regions = std::move(labels);
+    blockedRegions.clear();
+}
+
+void SearchGrid::journalBlocker(int cell)
+{
+    // Every change gets its own serial so a labelling can be patched from any point onwards
+    blockerJournal.push_back({++blockerSerial, cell});
+    if (blockerJournal.size() > maxJournalEntries) {
+        size_t dropped = blockerJournal.size() / 2;
+        journalStart = blockerJournal[dropped - 1].serial;
+        blockerJournal.erase(blockerJournal.begin(), blockerJournal.begin() + static_cast<std::ptrdiff_t>(dropped));
+    }
+}
+
+bool SearchGrid::canReach(int start, int goal, uint8_t blockerMask)
+{
+    if (!regions || start < 0 || start >= size() || goal < 0 || goal >= size()) return true;
+    // Danger only makes cells dearer, it never cuts them off
+    blockerMask &= static_cast<uint8_t>(~AvoidDanger);
+    // Walls alone separate them
+    if (!regions->connected(start, goal)) return false;
+    // Never entered, so a blocker under the start itself doesn't matter; don't guess
+    if (!blockerMask || isBlocked(start, blockerMask)) return true;
+
+    auto entry = std::find_if(blockedRegions.begin(), blockedRegions.end(),
+                              [blockerMask](const BlockedRegions &b) { return b.mask == blockerMask; });
+    if (entry == blockedRegions.end()) {
+        blockedRegions.push_back({blockerMask, 0, nullptr});
+        entry = blockedRegions.end() - 1;
+    }
+    if (!entry->labels || entry->serial < journalStart) {
+        // Single band: this already runs on a planning worker next to the others
+        entry->labels = std::make_unique<RegionLabels>(*this, blockerMask, 1);
+    } else if (entry->serial != blockerSerial) {
+        std::vector<int> changed;
+        for (const BlockerChange &c : blockerJournal) {
+            if (c.serial > entry->serial) changed.push_back(c.cell);
+        }
+        entry->labels->update(*this, changed);
+    }
+    entry->serial = blockerSerial;
+    const RegionLabels &labels = *entry->labels;
+    if (labels.connected(start, goal)) return true;
+    if (!isBlocked(goal, blockerMask)) return false;
+
+    // The goal is exempt from blockers (an enemy we walk into): any open neighbour will do
+    for (int d = 0; d < 8; ++d) {
+        int nx = xOf(goal) + dirDx[d];
+        int ny = yOf(goal) + dirDy[d];
+        if (inBounds(nx, ny) && labels.connected(start, index(nx, ny))) return true;
+    }
+    return false;
+}
+
+bool SearchGrid::isPassable(int idx) const noexcept
+{
+    return stepCost[idx] != std::numeric_limits<float>::infinity();
+}
+
+void SearchGrid::setBlocker(int idx, uint8_t flag, bool blocked)
+{
+    uint8_t before = blockers[idx];
+    if (blocked) {
+        blockers[idx] |= flag;
+    } else {
+        blockers[idx] &= static_cast<uint8_t>(~flag);
+    }
+    if (blockers[idx] != before) {
+        blockerVersion = nextBlockerVersion();
+        journalBlocker(idx);
+    }
+}
+
+void SearchGrid::clearBlockers()
+{
+    std::fill(blockers.begin(), blockers.end(), 0);
+    blockerVersion = nextBlockerVersion();
+    // Too many cells to journal; every labelling is rebuilt
+    journalStart = ++blockerSerial;
+    blockerJournal.clear();
+}
+
+std::vector<int> SearchGrid::findPath(int start, int goal, uint8_t blockerMask, SearchMode mode, float epsilon)
+{
+    if (start < 0 || start >= size() || goal < 0 || goal >= size()) {
+        return {};
+    }
+
+    bool bounded = mode == SearchMode::Weighted || mode == SearchMode::Focal;
+    epsilon = bounded ? std::max(1.0f, epsilon) : 1.0f;
+    lastQuery = QueryStats();
+    lastQuery.mode = mode;
+    lastQuery.epsilon = epsilon;
+    auto began = std::chrono::steady_clock::now();
+    std::vector<int> cells;
+    std::vector<int> path;
+
+    // Table lookup on levels with a path database; optimal for every mode. A path that runs
+    // into a blocker says nothing about the detour, so those queries search as usual
+    if (pathDatabase && !hasDanger(blockerMask) && pathDatabase->extractPath(*this, start, goal, blockerMask, path)
+                            != CompressedPathDatabase::Lookup::Blocked) {
+        int current = start;
+        for (int d : path) {
+            current = index(xOf(current) + dirDx[d], yOf(current) + dirDy[d]);
+            lastQuery.cost += stepCost[current];
+        }
+        lastQuery.fromDatabase = true;
+        lastQuery.steps = path.size();
+        lastQuery.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - began).count();
+        return path;
+    }
+
+    // Bounded modes are cached per epsilon (in hundredths), since their paths differ
+    uint32_t epsilonKey = static_cast<uint32_t>(std::lround(std::min(epsilon, 600.0f) * 100.0f));
+    uint32_t flags = blockerMask | (static_cast<uint32_t>(mode) << 8) | (epsilonKey << 16);
+    if (pathCache->lookup(start, goal, flags, blockerVersion, cells)) {
+        for (size_t i = 1; i < cells.size(); ++i) {
+            path.push_back(directionBetween(xOf(cells[i-1]), yOf(cells[i-1]), xOf(cells[i]), yOf(cells[i])));
+            lastQuery.cost += stepCost[cells[i]];
+        }
+        lastQuery.cached = true;
+        lastQuery.steps = path.size();
+        lastQuery.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - began).count();
+        return path;
+    }
+
+    path = searchUncached(start, goal, blockerMask, mode, epsilon);
+    lastQuery.expanded = workspace.expanded + (mode == SearchMode::Bidirectional ? backwardWorkspace.expanded : 0);
+    if (isCancelled()) return {};
+    if (!path.empty()) {
+        int current = start;
+        cells.push_back(current);
+        for (int d : path) {
+            current = index(xOf(current) + dirDx[d], yOf(current) + dirDy[d]);
+            cells.push_back(current);
+            lastQuery.cost += stepCost[current];
+        }
+    }
+    lastQuery.steps = path.size();
+    lastQuery.micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - began).count();
+    pathCache->store(start, goal, flags, blockerVersion, std::move(cells));
+    return path;
+}
+
+std::vector<int> SearchGrid::searchUncached(int start, int goal, uint8_t blockerMask, SearchMode mode, float epsilon)
+{
+    // Jump point search is only exact when every step costs the same
+    if (mode == SearchMode::JumpPoint && uniformCost && !hasDanger(blockerMask)) {
+        JumpPointSearch jps(*this, workspace);
+        return jps.findPath(start, goal, blockerMask);
+    }
+    if (mode == SearchMode::Bidirectional) {
+        BidirectionalSearch bidirectional(*this, workspace, backwardWorkspace);
+        return bidirectional.findPath(start, goal, blockerMask);
+    }
+    if (mode == SearchMode::Focal) {
+        FocalSearch focal(*this, workspace);
+        return focal.findPath(start, goal, blockerMask, epsilon);
+    }
+
+    auto costFunc = [this, goal, blockerMask](int, int b) {
+        return b == goal ? getStepCost(b) : getStepCost(b, blockerMask);
+    };
+    // Plain A* must be optimal and weighted A* needs the bound, so both use an admissible
+    // heuristic: octile distance at the cheapest step. The Euclidean distance in cells
+    // overestimates, since no step costs more than 0.1
+    float weight = mode == SearchMode::Weighted ? epsilon : 1.0f;
+    if (landmarks) {
+        return aStar(start, goal, costFunc, LandmarkHeuristic{landmarks.get(), cols, minStepCost}, weight);
+    }
+    return aStar(start, goal, costFunc, OctileHeuristic{cols, minStepCost, minStepCost}, weight);
+}
+
+std::vector<int> SearchGrid::reconstructPath(int start, int goal) const
+{
+    std::vector<int> path;
+    int current = goal;
+    while (current != start) {
+        int prev = static_cast<int>(workspace.parent[current]);
+        path.push_back(directionBetween(xOf(prev), yOf(prev), xOf(current), yOf(current)));
+        current = prev;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+float SearchGrid::euclideanDistance(int a, int b) const noexcept
+{
+    int dx = xOf(a) - xOf(b);
+    int dy = yOf(a) - yOf(b);
+    return std::sqrt(static_cast<float>(dx*dx + dy*dy));
+}
+
+int SearchGrid::directionBetween(int fromX, int fromY, int toX, int toY)
+{
+    int dx = toX - fromX;
+    int dy = toY - fromY;
+    for (int d = 0; d < 8; ++d) {
+        if (dirDx[d] == dx && dirDy[d] == dy) return d;
+    }
+    return -1;
+}
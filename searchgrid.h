@@ -0,0 +1,301 @@
+#ifndef SEARCHGRID_H
+#define SEARCHGRID_H
+
+#include "tile.h"
+#include "searchworkspace.h"
+#include "pathcache.h"
+#include "searchkernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+class LandmarkTable;
+class RegionLabels;
+class CompressedPathDatabase;
+
+// Which engine answers a path query. JumpPoint falls back to AStar on levels with weighted tiles.
+// Weighted and Focal are bounded-suboptimal: their paths cost at most epsilon times the optimum.
+enum class SearchMode { AStar, JumpPoint, Bidirectional, Weighted, Focal };
+
+/**
+ * @brief Speed/quality trade-off for one kind of query (click and goto, autoplay).
+ * Epsilon 1 keeps the caller's usual search; above 1 weighted A* (or focal search) is used.
+ */
+struct SearchPolicy {
+    float epsilon = 1.0f;
+    bool focal = false;
+
+    SearchMode modeFor(SearchMode exact) const noexcept {
+        return epsilon <= 1.0f ? exact : (focal ? SearchMode::Focal : SearchMode::Weighted);
+    }
+};
+
+/**
+ * @brief Flat, per-level search grid shared by autoplay and click-to-move.
+ *
+ * Step costs are stored row-major (index = y * cols + x) and built once when the
+ * level's tiles are set. The grid owns a SearchWorkspace (g/f values and 32-bit
+ * parent indices) that is allocated once as well; a generation counter tells
+ * which entries belong to the running query, so starting a new search costs O(1)
+ * instead of copying every tile into a fresh Node vector.
+ *
+ * Dynamic obstacles (undefeated enemies, portals) live in a per-cell blocker
+ * bitmap maintained by GameModel, so cost callbacks test a single byte instead
+ * of scanning the entity lists on every edge.
+ *
+ * Paths are returned in the same 0-7 direction encoding PathFinder used:
+ * 0 = up, then clockwise (1 = up-right, 2 = right, ... 7 = up-left).
+ */
+class SearchGrid {
+public:
+    enum BlockerFlag : uint8_t {
+        BlockEnemy  = 1 << 0,   // an undefeated enemy stands here
+        BlockPortal = 1 << 1,   // a portal, avoided while enemies are alive
+        AvoidDanger = 1 << 7    // mask only, never set on a cell: also pay the danger layer
+    };
+
+    static constexpr int dirDx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static constexpr int dirDy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+    SearchGrid(const std::vector<std::unique_ptr<TileWrapper>> &tiles, int rows, int cols);
+    ~SearchGrid();
+
+    // Level tables and settings a worker copy takes over; the GUI thread may replace them at any
+    // time, so they are read there (getWorkerSetup) and handed to the worker by value.
+    struct WorkerSetup {
+        std::shared_ptr<const LandmarkTable> landmarks;
+        std::shared_ptr<const RegionLabels> regions;
+        std::shared_ptr<const CompressedPathDatabase> pathDatabase;
+        OpenListKind openListKind = OpenListKind::BucketQueue;
+    };
+    WorkerSetup getWorkerSetup() const;
+    void applyWorkerSetup(const WorkerSetup &setup);
+
+    /**
+     * @brief Private copy for a planning thread: same step costs and path cache, no blockers, fresh workspaces.
+     * Only reads state that never changes after construction, plus setup, so it is safe to call
+     * while the GUI thread keeps editing this grid.
+     */
+    std::unique_ptr<SearchGrid> cloneForWorker(const WorkerSetup &setup) const;
+
+    // Same for a grid and its worker copies, different for every other level; per-level search
+    // state kept outside the grid (see AdaptiveSearch, DStarLite) is keyed on it.
+    uint64_t getLevelId() const noexcept { return levelId; }
+
+    int getRows() const noexcept { return rows; }
+    int getCols() const noexcept { return cols; }
+    int size() const noexcept { return rows * cols; }
+
+    bool inBounds(int x, int y) const noexcept { return x >= 0 && x < cols && y >= 0 && y < rows; }
+    int index(int x, int y) const noexcept { return y * cols + x; }
+    int xOf(int idx) const noexcept { return idx % cols; }
+    int yOf(int idx) const noexcept { return idx / cols; }
+
+    // Energy cost of stepping onto a cell: 1/(value+1)*0.1, or infinity for walls.
+    float getStepCost(int idx) const noexcept { return stepCost[idx]; }
+    bool isPassable(int idx) const noexcept;
+
+    // Step cost with blockers: infinity if any flag in mask is set on the cell. With AvoidDanger
+    // in mask the danger layer is already folded into the cost, so it is still a single load.
+    float getStepCost(int idx, uint8_t mask) const noexcept {
+        if (blockers[idx] & mask) return std::numeric_limits<float>::infinity();
+        return (mask & AvoidDanger) ? (*dangerStepCost)[idx] : stepCost[idx];
+    }
+    bool isBlocked(int idx, uint8_t mask) const noexcept { return (blockers[idx] & mask) != 0; }
+    void setBlocker(int idx, uint8_t flag, bool blocked);
+    void clearBlockers();
+    // Bumped whenever a blocker bit actually changes; results cached under an older version are stale.
+    uint64_t getBlockerVersion() const noexcept { return blockerVersion; }
+    // Danger layer (see InfluenceMap): extra energy-equivalent cost on top of a cell's step cost,
+    // paid only by queries with AvoidDanger in their mask. Changes bump the blocker version;
+    // setDanger() returns whether the cell's cost changed.
+    bool setDanger(int idx, float extraCost) noexcept;
+    void setDangerLayer(const std::vector<float> &extraCosts);
+    // True if mask asks for the danger layer and some cell carries danger; the path database and
+    // jump point search assume plain step costs, so findPath() skips them then.
+    bool hasDanger(uint8_t mask) const noexcept { return (mask & AvoidDanger) && dangerCells > 0; }
+    // Snapshot hand-off to worker copies (see PathPlanningService). The danger layer is shared
+    // rather than copied: the grid copies it only when it is written while a snapshot holds it.
+    const std::vector<uint8_t>& getBlockers() const noexcept { return blockers; }
+    std::shared_ptr<const std::vector<float>> getDangerStepCosts() const noexcept { return dangerStepCost; }
+    size_t getDangerCellCount() const noexcept { return dangerCells; }
+    void setBlockers(const std::vector<uint8_t> &bits, std::shared_ptr<const std::vector<float>> dangerCosts,
+                     size_t dangerCellCount, uint64_t version);
+
+    // Searches poll this flag and give up (returning no path) once it is set.
+    void setCancelFlag(const std::atomic<bool> *flag) noexcept { cancelFlag = flag; }
+    bool isCancelled() const noexcept { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); }
+
+    // True when every passable tile costs the same, i.e. jump point search is exact here.
+    bool hasUniformCost() const noexcept { return uniformCost; }
+    // Cheapest step on the level (0 if nothing is passable); scales admissible heuristics.
+    float getMinStepCost() const noexcept { return minStepCost; }
+
+    // ALT tables for this level (see LandmarkTable); A* and jump point search use them when set.
+    void setLandmarks(std::shared_ptr<const LandmarkTable> table) { landmarks = std::move(table); }
+    const LandmarkTable* getLandmarks() const noexcept { return landmarks.get(); }
+
+    // First-move table for the level's tiles (see CompressedPathDatabase); findPath() tries it before searching.
+    void setPathDatabase(std::shared_ptr<const CompressedPathDatabase> db) { pathDatabase = std::move(db); }
+    const CompressedPathDatabase* getPathDatabase() const noexcept { return pathDatabase.get(); }
+
+    // Connected regions of the level's tiles (see RegionLabels), used by canReach().
+    void setRegions(std::shared_ptr<const RegionLabels> labels);
+    const RegionLabels* getRegions() const noexcept { return regions.get(); }
+
+    /**
+     * @brief False when no path can exist from start to goal with blockerMask applied. True when
+     * unsure, e.g. before regions are set. O(1) with no mask; with one, the first call labels the
+     * level under that mask and later calls only patch the regions around changed blockers, so
+     * masked queries belong on a planning worker.
+     */
+    bool canReach(int start, int goal, uint8_t blockerMask);
+
+    // Open list used by every search on this grid (both workspaces); bucket queue by default.
+    void setOpenListKind(OpenListKind kind);
+    OpenListKind getOpenListKind() const noexcept { return workspace.getOpenListKind(); }
+
+    /**
+     * @brief Path from start to goal avoiding cells whose blocker flags intersect blockerMask.
+     * The goal cell itself is never treated as blocked (it may hold the enemy we are heading for).
+     * Answers come from the path database when one is set and its path avoids the blockers,
+     * otherwise from the path cache while the blocker version is unchanged.
+     * epsilon (>= 1) bounds the path cost of the Weighted and Focal modes; the others ignore it.
+     */
+    std::vector<int> findPath(int start, int goal, uint8_t blockerMask, SearchMode mode = SearchMode::AStar,
+                              float epsilon = 1.0f);
+
+    // What the last findPath() call did; nothing is expanded when the path cache answers.
+    struct QueryStats {
+        SearchMode mode = SearchMode::AStar;
+        float epsilon = 1.0f;
+        bool cached = false;
+        bool fromDatabase = false; // answered by the path database: optimal, nothing searched
+        uint64_t expanded = 0;
+        float cost = 0.0f; // energy along the path, 0 if none was found
+        size_t steps = 0;
+        double micros = 0.0;
+    };
+    const QueryStats& getLastQuery() const noexcept { return lastQuery; }
+
+    /**
+     * @brief A* from start to goal (cell indices). Returns an empty path if unreachable.
+     * cost(from, to) and heuristic(from, to) are template parameters so both get inlined into
+     * the relaxation loop; pass a GridHeuristic kernel or any callable returning float.
+     */
+    template <typename CostFn, typename HeuristicFn>
+    std::vector<int> aStar(int start, int goal, const CostFn &cost, const HeuristicFn &heuristic,
+                           float heuristicWeight = 1.0f);
+
+    // Walks the parent chain of the last search from goal back to start.
+    std::vector<int> reconstructPath(int start, int goal) const;
+
+    float euclideanDistance(int a, int b) const noexcept;
+
+    SearchWorkspace& getWorkspace() noexcept { return workspace; }
+    // Shared with the worker copies, so its counters cover queries planned on any of them
+    const PathCache& getPathCache() const noexcept { return *pathCache; }
+
+    static int directionBetween(int fromX, int fromY, int toX, int toY);
+
+private:
+    SearchGrid(const SearchGrid &other);
+
+    std::vector<int> searchUncached(int start, int goal, uint8_t blockerMask, SearchMode mode, float epsilon);
+
+    int rows;
+    int cols;
+    uint64_t levelId;
+    std::vector<float> stepCost;
+    std::shared_ptr<const std::vector<float>> dangerStepCost; // stepCost plus the danger layer
+    size_t dangerCells = 0;
+    std::vector<float>& writableDanger();
+    std::vector<uint8_t> blockers;
+    bool uniformCost;
+    float minStepCost;
+
+    SearchWorkspace workspace;
+    SearchWorkspace backwardWorkspace; // second frontier of SearchMode::Bidirectional
+
+    std::shared_ptr<const LandmarkTable> landmarks;
+    std::shared_ptr<const RegionLabels> regions;
+    std::shared_ptr<const CompressedPathDatabase> pathDatabase;
+    // Regions with blockers, one labelling per mask, patched from the blocker journal below
+    struct BlockedRegions {
+        uint8_t mask;
+        uint64_t serial; // blockerSerial the labels reflect
+        std::unique_ptr<RegionLabels> labels;
+    };
+    std::vector<BlockedRegions> blockedRegions;
+    // Cells whose blocker bits changed, tagged with a per-grid serial; entries at or below
+    // journalStart were dropped, so labels older than that are rebuilt instead
+    struct BlockerChange {
+        uint64_t serial;
+        int cell;
+    };
+    std::vector<BlockerChange> blockerJournal;
+    uint64_t blockerSerial = 0;
+    uint64_t journalStart = 0;
+    static constexpr size_t maxJournalEntries = 4096;
+    void journalBlocker(int cell);
+
+    uint64_t blockerVersion;
+    std::shared_ptr<PathCache> pathCache; // set at construction, never reassigned
+    QueryStats lastQuery;
+    const std::atomic<bool> *cancelFlag = nullptr;
+};
+
+template <typename CostFn, typename HeuristicFn>
+std::vector<int> SearchGrid::aStar(int start, int goal, const CostFn &cost, const HeuristicFn &heuristic,
+                                   float heuristicWeight)
+{
+    if (start < 0 || start >= size() || goal < 0 || goal >= size() || start == goal) {
+        return {};
+    }
+
+    SearchWorkspace &ws = workspace;
+    // Weighted runs close expanded cells for good (f = -inf makes their queued entries stale):
+    // the bound holds without reopening, and reopening is what makes them expand more than A*
+    const bool reopen = heuristicWeight <= 1.0f;
+    const float closed = -std::numeric_limits<float>::infinity();
+    ws.begin(size());
+    ws.reach(start, 0.0f, start);
+    ws.f[start] = heuristicWeight * heuristic(start, goal);
+    ws.push(ws.f[start], start);
+
+    while (!ws.openEmpty() && !isCancelled()) {
+        SearchWorkspace::OpenEntry current = ws.pop();
+
+        // Lazy deletion: a cheaper route to this cell was pushed after this entry
+        if (current.f > ws.f[current.index]) continue;
+        ++ws.expanded;
+        if (current.index == goal) return reconstructPath(start, goal);
+        if (!reopen) ws.f[current.index] = closed;
+
+        int cx = xOf(current.index);
+        int cy = yOf(current.index);
+        for (int d = 0; d < 8; ++d) {
+            int nx = cx + dirDx[d];
+            int ny = cy + dirDy[d];
+            if (!inBounds(nx, ny)) continue;
+
+            int next = index(nx, ny);
+            float step = cost(current.index, next);
+            if (step == std::numeric_limits<float>::infinity()) continue;
+
+            float newG = ws.g[current.index] + step;
+            if (ws.isReached(next) && (newG >= ws.g[next] || ws.f[next] == closed)) continue;
+
+            ws.reach(next, newG, current.index);
+            ws.f[next] = newG + heuristicWeight * heuristic(next, goal);
+            ws.push(ws.f[next], next);
+        }
+    }
+
+    return {};
+}
+
+#endif // SEARCHGRID_H
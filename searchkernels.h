@@ -0,0 +1,45 @@
+#ifndef SEARCHKERNELS_H
+#define SEARCHKERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+/**
+ * @brief Heuristic kernels for SearchGrid::aStar, selected at compile time.
+ *
+ * Passed by value as template arguments, so the compiler inlines them into the
+ * relaxation loop instead of calling through a std::function on every edge.
+ * All kernels work on row-major cell indices of a grid with the given column count.
+ */
+enum class HeuristicKind { Octile, Euclidean, Zero };
+
+template <HeuristicKind Kind>
+struct GridHeuristic {
+    int cols;
+    float straightCost = 1.0f; // cost of one straight step
+    float diagonalCost = 1.0f; // cost of one diagonal step (equal to straight in this game)
+
+    float operator()(int from, int to) const noexcept
+    {
+        if constexpr (Kind == HeuristicKind::Zero) {
+            return 0.0f;
+        } else {
+            int dx = std::abs(from % cols - to % cols);
+            int dy = std::abs(from / cols - to / cols);
+            if constexpr (Kind == HeuristicKind::Octile) {
+                int diagonal = std::min(dx, dy);
+                int straight = std::max(dx, dy) - diagonal;
+                return diagonalCost * static_cast<float>(diagonal) + straightCost * static_cast<float>(straight);
+            } else {
+                return std::sqrt(static_cast<float>(dx*dx + dy*dy));
+            }
+        }
+    }
+};
+
+using OctileHeuristic = GridHeuristic<HeuristicKind::Octile>;
+using EuclideanHeuristic = GridHeuristic<HeuristicKind::Euclidean>;
+using ZeroHeuristic = GridHeuristic<HeuristicKind::Zero>;
+
+#endif // SEARCHKERNELS_H
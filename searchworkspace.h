@@ -0,0 +1,107 @@
+#ifndef SEARCHWORKSPACE_H
+#define SEARCHWORKSPACE_H
+
+#include "bucketqueue.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Open list behind SearchWorkspace::push/pop. BucketQueue orders by f quantized to 1/64.
+enum class OpenListKind { BinaryHeap, BucketQueue };
+
+/**
+ * @brief Reusable per-cell search state (g/f values, 32-bit parent indices) plus the open list.
+ *
+ * Entries are only valid where the cell's stamp matches the current generation,
+ * so begin() resets the whole workspace in O(1). Arrays are sized on first use
+ * and kept for the lifetime of the level.
+ */
+class SearchWorkspace {
+public:
+    struct OpenEntry {
+        float f;
+        int index;
+        bool operator>(const OpenEntry &other) const { return f > other.f; }
+    };
+
+    std::vector<float> g;
+    std::vector<float> f;
+    std::vector<uint32_t> parent;
+    uint64_t expanded = 0; // cells expanded since begin(), counted by the search engines
+
+    void begin(int cellCount)
+    {
+        if (stamp.size() != static_cast<size_t>(cellCount)) {
+            g.resize(cellCount);
+            f.resize(cellCount);
+            parent.resize(cellCount);
+            stamp.assign(cellCount, 0);
+            generation = 0;
+        }
+
+        ++generation;
+        if (generation == 0) {
+            // Counter wrapped: clear the stamps once so stale entries can't alias
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        open.clear();
+        buckets.clear();
+        expanded = 0;
+    }
+
+    // Takes effect immediately; only switch between searches.
+    void setOpenListKind(OpenListKind kind)
+    {
+        openKind = kind;
+        open.clear();
+        buckets.clear();
+    }
+    OpenListKind getOpenListKind() const noexcept { return openKind; }
+
+    bool isReached(int idx) const noexcept { return stamp[idx] == generation; }
+
+    void reach(int idx, float gValue, int parentIdx) noexcept
+    {
+        stamp[idx] = generation;
+        g[idx] = gValue;
+        parent[idx] = static_cast<uint32_t>(parentIdx);
+    }
+
+    void push(float fValue, int idx)
+    {
+        if (openKind == OpenListKind::BucketQueue) {
+            buckets.push(fValue, idx);
+            return;
+        }
+        open.push_back({fValue, idx});
+        std::push_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+    }
+
+    OpenEntry pop()
+    {
+        if (openKind == OpenListKind::BucketQueue) {
+            BucketQueue::Entry top = buckets.pop();
+            return {top.f, top.index};
+        }
+        std::pop_heap(open.begin(), open.end(), std::greater<OpenEntry>());
+        OpenEntry top = open.back();
+        open.pop_back();
+        return top;
+    }
+
+    // Smallest f on the open list (stale entries included); the list must not be empty
+    float openMinKey() const { return openKind == OpenListKind::BucketQueue ? buckets.minKey() : open.front().f; }
+    bool openEmpty() const noexcept { return openKind == OpenListKind::BucketQueue ? buckets.empty() : open.empty(); }
+    size_t openSize() const noexcept { return openKind == OpenListKind::BucketQueue ? buckets.size() : open.size(); }
+
+private:
+    std::vector<uint32_t> stamp;
+    uint32_t generation = 0;
+    OpenListKind openKind = OpenListKind::BucketQueue;
+    std::vector<OpenEntry> open;
+    BucketQueue buckets;
+};
+
+#endif // SEARCHWORKSPACE_H
@@ -9,7 +9,8 @@ public:
     virtual ~XEnemyWrapper() = default;
 
     explicit XEnemyWrapper(std::unique_ptr<Enemy> e, int cols, int rows)
-        : EnemyWrapper(std::move(e)), mapCols(cols), mapRows(rows), timesHit(0), justTeleported(false)
+        : EnemyWrapper(std::move(e)), mapCols(cols), mapRows(rows), timesHit(0), justTeleported(false),
+        oldX(getXPos()), oldY(getYPos())
     {}
 
     void hit() {
@@ -22,6 +23,8 @@ public:
             int x = distX(gen);
             int y = distY(gen);
 
+            oldX = getXPos();
+            oldY = getYPos();
             getRaw()->setXPos(x);
             getRaw()->setYPos(y);
 